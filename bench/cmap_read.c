@@ -0,0 +1,113 @@
+#define _POSIX_C_SOURCE 199309L
+#define UTOPIA_IMPLEMENTATION
+#define UTOPIA_HASH_UINT
+#include <utopia/cmap.h>
+#include <utopia/map.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define KEYS (1 << 20)
+#define LOOKUPS (1 << 22)
+#define MAX_THREADS 64
+
+struct bench {
+    struct cmap* cmap;
+    struct map* map;
+    pthread_mutex_t* lock;
+    size_t seed;
+    size_t found;
+};
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void* bench_cmap(void* arg)
+{
+    size_t i, key, value;
+    struct bench* b = arg;
+    for (i = 0; i < LOOKUPS; ++i) {
+        key = (i * 2654435761UL + b->seed) % KEYS;
+        b->found += cmap_search(b->cmap, &key, &value);
+    }
+    return NULL;
+}
+
+static void* bench_mutex(void* arg)
+{
+    size_t i, key;
+    struct bench* b = arg;
+    for (i = 0; i < LOOKUPS; ++i) {
+        key = (i * 2654435761UL + b->seed) % KEYS;
+        pthread_mutex_lock(b->lock);
+        b->found += map_search(b->map, &key) != 0;
+        pthread_mutex_unlock(b->lock);
+    }
+    return NULL;
+}
+
+static double bench_run(struct bench* benches, const size_t threads, void* (*worker)(void*))
+{
+    size_t i;
+    double start;
+    pthread_t handles[MAX_THREADS];
+    start = bench_now();
+    for (i = 0; i < threads; ++i) {
+        benches[i].found = 0;
+        pthread_create(handles + i, NULL, worker, benches + i);
+    }
+
+    for (i = 0; i < threads; ++i) {
+        pthread_join(handles[i], NULL);
+        if (benches[i].found != LOOKUPS) {
+            fprintf(stderr, "missing keys in thread %lu\n", (unsigned long)i);
+        }
+    }
+    return (double)(threads * LOOKUPS) / (bench_now() - start) * 1e-6;
+}
+
+int main(int argc, char** argv)
+{
+    size_t i, threads, cores = (size_t)sysconf(_SC_NPROCESSORS_ONLN);
+    struct bench benches[MAX_THREADS];
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    struct cmap cmap = cmap_create(sizeof(size_t), sizeof(size_t));
+    struct map map = map_create(sizeof(size_t), sizeof(size_t));
+    if (argc > 1) {
+        cores = (size_t)atol(argv[1]);
+    }
+    cores = cores < 1 ? 1 : cores > MAX_THREADS ? MAX_THREADS : cores;
+
+    for (i = 0; i < KEYS; ++i) {
+        cmap_push(&cmap, &i, &i);
+        map_push(&map, &i, &i);
+    }
+
+    for (i = 0; i < MAX_THREADS; ++i) {
+        benches[i].cmap = &cmap;
+        benches[i].map = &map;
+        benches[i].lock = &lock;
+        benches[i].seed = i * 7919;
+    }
+
+    printf("%lu keys, %lu lookups per thread, up to %lu threads\n", 
+           (unsigned long)KEYS, (unsigned long)LOOKUPS, (unsigned long)cores);
+    printf("threads  cmap Mops/s  mutex map Mops/s\n");
+    for (threads = 1; ; threads = threads * 2 < cores ? threads * 2 : cores) {
+        const double c = bench_run(benches, threads, &bench_cmap);
+        const double m = bench_run(benches, threads, &bench_mutex);
+        printf("%7lu  %11.1f  %16.1f\n", (unsigned long)threads, c, m);
+        if (threads == cores) {
+            break;
+        }
+    }
+
+    cmap_free(&cmap);
+    map_free(&map);
+    return 0;
+}
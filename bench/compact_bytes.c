@@ -0,0 +1,58 @@
+#define UTOPIA_IMPLEMENTATION
+#define UTOPIA_HASH_UINT
+#include <utopia/map.h>
+#include <utopia/set.h>
+#include <stdio.h>
+
+static void bench_map(const size_t count)
+{
+    size_t i;
+    struct map_stats a, b;
+    struct map plain = map_create(sizeof(unsigned int), sizeof(unsigned int));
+    struct map compact = map_create_compact(sizeof(unsigned int), sizeof(unsigned int));
+    for (i = 0; i < count; ++i) {
+        const unsigned int key = (unsigned int)i, value = (unsigned int)(i * 3);
+        map_push(&plain, &key, &value);
+        map_push(&compact, &key, &value);
+    }
+
+    a = map_stats(&plain);
+    b = map_stats(&compact);
+    printf("map  %9lu  %13.1f  %15.1f\n", (unsigned long)count, 
+           (double)a.bytes / (double)a.size, (double)b.bytes / (double)b.size);
+    map_free(&plain);
+    map_free(&compact);
+}
+
+static void bench_set(const size_t count)
+{
+    size_t i;
+    struct set_stats a, b;
+    struct set plain = set_create(sizeof(size_t));
+    struct set compact = set_create_compact(sizeof(size_t));
+    for (i = 0; i < count; ++i) {
+        set_push(&plain, &i);
+        set_push(&compact, &i);
+    }
+
+    a = set_stats(&plain);
+    b = set_stats(&compact);
+    printf("set  %9lu  %13.1f  %15.1f\n", (unsigned long)count, 
+           (double)a.bytes / (double)a.size, (double)b.bytes / (double)b.size);
+    set_free(&plain);
+    set_free(&compact);
+}
+
+int main(void)
+{
+    size_t count;
+    printf("kind  %9s  %13s  %15s\n", "entries", "bytes/entry", "compact b/entry");
+    for (count = 1000; count <= 1000000; count *= 10) {
+        bench_map(count);
+    }
+
+    for (count = 1000; count <= 1000000; count *= 10) {
+        bench_set(count);
+    }
+    return 0;
+}
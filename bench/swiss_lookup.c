@@ -0,0 +1,62 @@
+#define _POSIX_C_SOURCE 199309L
+#define UTOPIA_IMPLEMENTATION
+#define UTOPIA_HASH_UINT
+#include <utopia/map.h>
+#include <utopia/swiss.h>
+#include <stdio.h>
+#include <time.h>
+
+#define LOOKUPS (1 << 22)
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static size_t bench_key(const size_t i, const size_t count)
+{
+    return (i * 2654435761UL) % (2 * count);
+}
+
+static void bench_lookup(const size_t count)
+{
+    size_t i, key, found = 0;
+    double start, map_ns, swiss_ns;
+    struct map map = map_create(sizeof(size_t), sizeof(size_t));
+    struct swiss swiss = swiss_create(sizeof(size_t), sizeof(size_t));
+    for (i = 0; i < count; ++i) {
+        key = 2 * i;
+        map_push(&map, &key, &i);
+        swiss_push(&swiss, &key, &i);
+    }
+
+    start = bench_now();
+    for (i = 0; i < LOOKUPS; ++i) {
+        key = bench_key(i, count);
+        found += !!map_search(&map, &key);
+    }
+    map_ns = (bench_now() - start) * 1e9 / LOOKUPS;
+
+    start = bench_now();
+    for (i = 0; i < LOOKUPS; ++i) {
+        key = bench_key(i, count);
+        found -= !!swiss_search(&swiss, &key);
+    }
+    swiss_ns = (bench_now() - start) * 1e9 / LOOKUPS;
+
+    printf("%9lu  %10.1f  %10.1f%s\n", (unsigned long)count, map_ns, swiss_ns, found ? "  mismatch" : "");
+    map_free(&map);
+    swiss_free(&swiss);
+}
+
+int main(void)
+{
+    size_t count;
+    printf("%9s  %10s  %10s\n", "entries", "map ns", "swiss ns");
+    for (count = 1000; count <= (1 << 22); count *= 4) {
+        bench_lookup(count);
+    }
+    return 0;
+}
@@ -34,6 +34,10 @@ elif echo "$OSTYPE" | grep -q "linux"; then
     suffix=.so
 fi
 
+libs=(
+    -lpthread
+)
+
 cmd() {
     echo "$@" && $@
 }
@@ -51,7 +55,7 @@ objs() {
 shared() {
     [ -d $tmp ] || objs
     cmd mkdir -p $bin
-    cmd $cc $tmp/*.o -o $bin/$name$suffix ${dlib[*]}
+    cmd $cc $tmp/*.o -o $bin/$name$suffix ${dlib[*]} ${libs[*]}
 }
 
 static() {
@@ -0,0 +1,65 @@
+#define UTOPIA_IMPLEMENTATION
+#include <utopia/bitset.h>
+#include <assert.h>
+#include <stdio.h>
+
+#define RANGE 65536
+
+static void check(const struct bitset* bitset, const char* expect)
+{
+    size_t i;
+    for (i = 0; i < RANGE; ++i) {
+        assert(bitset_search(bitset, i) == expect[i]);
+    }
+}
+
+int main(void)
+{
+    size_t i, base;
+    static char ea[RANGE], eb[RANGE], eu[RANGE], ei[RANGE], ed[RANGE], ex[RANGE];
+    struct bitset a = bitset_create(), b = bitset_create(), r;
+    for (i = 0; i < 1000; ++i) {
+        bitset_push(&a, i);
+        ea[i] = 1;
+    }
+    
+    bitset_optimize(&a);
+    base = bitset_bytes(&a);
+    assert(base < 256);
+    for (i = 2000; i < RANGE; i += 2) {
+        bitset_push(&a, i);
+        ea[i] = 1;
+        assert(bitset_bytes(&a) <= base + 8192);
+    }
+    check(&a, ea);
+
+    for (i = 0; i < RANGE; i += 3) {
+        bitset_push(&b, i);
+        eb[i] = 1;
+    }
+
+    for (i = 0; i < RANGE; ++i) {
+        eu[i] = ea[i] | eb[i];
+        ei[i] = ea[i] & eb[i];
+        ed[i] = ea[i] & !eb[i];
+        ex[i] = ea[i] ^ eb[i];
+    }
+
+    r = bitset_union(&a, &b);
+    check(&r, eu);
+    bitset_free(&r);
+    r = bitset_intersect(&a, &b);
+    check(&r, ei);
+    bitset_free(&r);
+    r = bitset_difference(&a, &b);
+    check(&r, ed);
+    bitset_free(&r);
+    r = bitset_symmetric_difference(&a, &b);
+    check(&r, ex);
+    bitset_free(&r);
+
+    bitset_free(&a);
+    bitset_free(&b);
+    printf("bitset_run: ok\n");
+    return 0;
+}
@@ -0,0 +1,21 @@
+#define UTOPIA_IMPLEMENTATION
+#include <utopia/hash.h>
+#include <utopia/map.h>
+#include <assert.h>
+#include <stdio.h>
+
+int main(void)
+{
+    char a[] = "key", b[] = "key";
+    char* ka = a, *kb = b;
+    size_t value = 1;
+    struct map map = map_create(sizeof(char*), sizeof(size_t));
+    map_overload_seeded(&map, &hash_string, hash_seed());
+    map_overload_eq(&map, &equal_string);
+    map_push(&map, &ka, &value);
+    assert(map_search(&map, &kb));
+    assert(map_push_if(&map, &kb, &value) && map_size(&map) == 1);
+    map_free(&map);
+    printf("hash_string: ok\n");
+    return 0;
+}
@@ -0,0 +1,40 @@
+#define UTOPIA_IMPLEMENTATION
+#define UTOPIA_HASH_UINT
+#include <utopia/map.h>
+#include <assert.h>
+#include <stdio.h>
+
+#define COUNT 1000
+#define IMAGE "map_filter.img"
+
+int main(void)
+{
+    size_t i;
+    struct map map = map_create(sizeof(size_t), sizeof(size_t)), image;
+    for (i = 0; i < COUNT; ++i) {
+        map_push(&map, &i, &i);
+    }
+    assert(map_save(&map, IMAGE));
+    
+    image = map_open_mmap(IMAGE);
+    assert(MAP_MODE(&image, image));
+    map_filter(&image, 0.01);
+    i = COUNT;
+    map_push(&image, &i, &i);
+    assert(!MAP_MODE(&image, image));
+    for (i = 0; i <= COUNT; ++i) {
+        assert(map_search(&image, &i));
+    }
+    map_free(&image);
+
+    image = map_open_mmap(IMAGE);
+    map_filter(&image, 0.01);
+    i = 3;
+    assert(map_remove(&image, &i) && !map_search(&image, &i));
+    map_free(&image);
+
+    map_free(&map);
+    remove(IMAGE);
+    printf("map_filter: ok\n");
+    return 0;
+}
@@ -0,0 +1,73 @@
+#define UTOPIA_IMPLEMENTATION
+#define UTOPIA_HASH_UINT
+#include <utopia/map.h>
+#include <assert.h>
+#include <stdio.h>
+
+#define COUNT 100000
+
+static size_t hash_weak(const void* key, const size_t bytes, const size_t seed)
+{
+    size_t x = *(const size_t*)key;
+    (void)bytes;
+    return seed ? (x ^ seed) * 0x9E3779B97F4A7C15 : x / 2;
+}
+
+static size_t map_get(const struct map* map, const size_t key)
+{
+    const size_t find = map_search(map, &key);
+    assert(find);
+    return *(size_t*)map_value_at(map, find - 1);
+}
+
+static size_t hash_half(const void* key)
+{
+    return *(const size_t*)key / 2;
+}
+
+int main(void)
+{
+    size_t i, seed;
+    struct map map = map_create(sizeof(size_t), sizeof(size_t)), copy;
+    for (i = 0; i < COUNT; ++i) {
+        map_push(&map, &i, &i);
+    }
+    assert(map_freeze(&map));
+    assert(MAP_PILOT_SPILL(map.mode->pilots, map.mode->pilot_mod)[0]);
+    assert(map_pilot_bytes(&map) * 8 < map.size * 5);
+    copy = map_copy(&map);
+    for (i = 0; i < COUNT; ++i) {
+        assert(map_get(&map, i) == i);
+        assert(map_get(&copy, i) == i);
+    }
+    assert(!map_search(&map, &i));
+    map_free(&copy);
+    map_free(&map);
+
+    map = map_create(sizeof(size_t), sizeof(size_t));
+    map_overload_seeded(&map, &hash_weak, 0);
+    for (i = 0; i < 1000; ++i) {
+        map_push(&map, &i, &i);
+    }
+    assert(map_freeze(&map));
+    seed = map.seed;
+    assert(seed);
+    for (i = 0; i < 1000; ++i) {
+        assert(map_get(&map, i) == i);
+    }
+    map_free(&map);
+
+    map = map_create(sizeof(size_t), sizeof(size_t));
+    map_overload(&map, &hash_half);
+    for (i = 0; i < 1000; ++i) {
+        map_push(&map, &i, &i);
+    }
+    assert(!map_freeze(&map));
+    for (i = 0; i < 1000; ++i) {
+        assert(map_get(&map, i) == i);
+    }
+    map_free(&map);
+
+    printf("map_freeze: ok\n");
+    return 0;
+}
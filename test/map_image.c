@@ -0,0 +1,69 @@
+#define UTOPIA_IMPLEMENTATION
+#define UTOPIA_HASH_UINT
+#include <utopia/map.h>
+#include <assert.h>
+#include <stdio.h>
+
+#define COUNT 100
+#define IMAGE "map_image.img"
+
+static size_t image_read(char* buffer, const size_t bytes)
+{
+    size_t read;
+    FILE* file = fopen(IMAGE, "rb");
+    read = fread(buffer, 1, bytes, file);
+    fclose(file);
+    return read;
+}
+
+static int image_opens(const char* buffer, const size_t bytes)
+{
+    int opened;
+    struct map map;
+    FILE* file = fopen(IMAGE, "wb");
+    fwrite(buffer, 1, bytes, file);
+    fclose(file);
+    map = map_open_mmap(IMAGE);
+    opened = MAP_MODE(&map, image) != NULL;
+    map_free(&map);
+    return opened;
+}
+
+int main(void)
+{
+    size_t i, bytes, *header, *packed;
+    static char image[1 << 16], corrupt[1 << 16];
+    struct map map = map_create(sizeof(size_t), sizeof(size_t));
+    for (i = 0; i < COUNT; ++i) {
+        map_push(&map, &i, &i);
+    }
+    assert(map_save(&map, IMAGE));
+    bytes = image_read(image, sizeof(image));
+    assert(image_opens(image, bytes));
+    header = (size_t*)corrupt;
+    packed = (size_t*)(corrupt + ((size_t*)image)[MAP_IMAGE_PACKED_INDEX]);
+
+#define CORRUPT(stmt, len) \
+    memcpy(corrupt, image, bytes); stmt; assert(!image_opens(corrupt, len))
+
+    CORRUPT((void)0, bytes - 8);
+    CORRUPT(header[MAP_IMAGE_BYTES_INDEX] -= 8, bytes - 8);
+    CORRUPT(header[MAP_IMAGE_SIZE_INDEX] += 1, bytes);
+    CORRUPT(header[MAP_IMAGE_SIZE_INDEX] = ~(size_t)0, bytes);
+    CORRUPT(header[MAP_IMAGE_MOD_INDEX] = ~(size_t)0, bytes);
+    CORRUPT(header[MAP_IMAGE_KEY_BYTES_INDEX] = 0, bytes);
+    CORRUPT(header[MAP_IMAGE_VALUE_BYTES_INDEX] = bytes, bytes);
+    CORRUPT(header[MAP_IMAGE_HASHES_INDEX] = bytes, bytes);
+    CORRUPT(header[MAP_IMAGE_KEYS_INDEX] += 1, bytes);
+    CORRUPT(header[MAP_IMAGE_VALUES_INDEX] = ~(size_t)0 - 7, bytes);
+    CORRUPT(header[MAP_IMAGE_ARENA_BYTES_INDEX] = 16, bytes);
+    CORRUPT(packed[map.mod] -= 1, bytes);
+    CORRUPT(packed[1] = COUNT + 1, bytes);
+    CORRUPT(packed[map.mod + 1] = COUNT, bytes);
+#undef CORRUPT
+
+    map_free(&map);
+    remove(IMAGE);
+    printf("map_image: ok\n");
+    return 0;
+}
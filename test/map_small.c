@@ -0,0 +1,71 @@
+#define UTOPIA_IMPLEMENTATION
+#include <utopia/map.h>
+#include <utopia/set.h>
+#include <assert.h>
+#include <stdio.h>
+
+#define HALF (sizeof(size_t) * 4)
+#define COUNT 1000
+
+static size_t identity(const void* key)
+{
+    return *(const size_t*)key;
+}
+
+static size_t key_at(const size_t i)
+{
+    return (i & 3) + ((i >> 2) << HALF);
+}
+
+int main(void)
+{
+    size_t i, key;
+    struct map map = map_create(sizeof(size_t), sizeof(size_t));
+    struct set set = set_create(sizeof(size_t));
+    map_overload(&map, identity);
+    set_overload(&set, identity);
+    for (i = 0; i < UTOPIA_MAP_SMALL; ++i) {
+        key = key_at(i);
+        map_push(&map, &key, &i);
+    }
+    for (i = 0; i < UTOPIA_SET_SMALL; ++i) {
+        key = key_at(i);
+        set_push(&set, &key);
+    }
+    assert(map.hashes && set.hashes);
+
+    for (i = 0; i < UTOPIA_MAP_SMALL; ++i) {
+        key = key_at(i);
+        assert(map_search(&map, &key) == i + 1);
+    }
+    for (i = 0; i < UTOPIA_SET_SMALL; ++i) {
+        key = key_at(i);
+        assert(set_search(&set, &key) == i + 1);
+    }
+
+    key = 4;
+    assert(!map_search(&map, &key) && !set_search(&set, &key));
+    key = (size_t)4 << HALF;
+    assert(!map_search(&map, &key) && !set_search(&set, &key));
+    key = 1 + ((size_t)5 << HALF);
+    assert(!map_search(&map, &key) && !set_search(&set, &key));
+
+    key = key_at(5);
+    assert(map_remove(&map, &key) && set_remove(&set, &key));
+    assert(!map_search(&map, &key) && !set_search(&set, &key));
+    key = key_at(6);
+    assert(map_search(&map, &key) == 6 && set_search(&set, &key) == 6);
+    assert(!map_stats(&map).resizes && !set_stats(&set).resizes);
+
+    for (i = UTOPIA_MAP_SMALL; i < COUNT; ++i) {
+        key = key_at(i);
+        map_push(&map, &key, &i);
+        set_push(&set, &key);
+    }
+    assert(map_stats(&map).resizes && set_stats(&set).resizes);
+
+    map_free(&map);
+    set_free(&set);
+    printf("map_small: ok\n");
+    return 0;
+}
@@ -0,0 +1,57 @@
+#define UTOPIA_IMPLEMENTATION
+#define UTOPIA_HASH_UINT
+#include <utopia/map.h>
+#include <utopia/set.h>
+#include <assert.h>
+#include <stdio.h>
+
+#define COUNT 1000
+#define IMAGE "map_snapshot.img"
+
+static size_t value_of(const struct map* map, const size_t key)
+{
+    const size_t index = map_search(map, &key);
+    assert(index);
+    return *(size_t*)map_value_at(map, index - 1);
+}
+
+int main(void)
+{
+    size_t i, index;
+    struct map map = map_create(sizeof(size_t), sizeof(size_t)), snapshot;
+    struct set set = set_create(sizeof(size_t)), frozen;
+    for (i = 0; i < COUNT; ++i) {
+        map_push(&map, &i, &i);
+        set_push(&set, &i);
+    }
+
+    snapshot = map_snapshot(&map);
+    assert(map_value_at(&map, 0) == map_value_at(&snapshot, 0));
+    i = 7;
+    index = map_search(&map, &i);
+    *(size_t*)map_value_mut(&map, index - 1) = COUNT;
+    assert(value_of(&map, 7) == COUNT && value_of(&snapshot, 7) == 7);
+    assert(map_value_at(&map, 0) != map_value_at(&snapshot, 0));
+    map_free(&snapshot);
+
+    assert(map_save(&map, IMAGE));
+    snapshot = map_open_mmap(IMAGE);
+    i = 9;
+    index = map_search(&snapshot, &i);
+    *(size_t*)map_value_mut(&snapshot, index - 1) = COUNT;
+    assert(value_of(&snapshot, 9) == COUNT && value_of(&snapshot, 7) == COUNT);
+    map_free(&snapshot);
+
+    frozen = set_snapshot(&set);
+    i = COUNT;
+    set_push(&set, &i);
+    assert(set_search(&set, &i) && !set_search(&frozen, &i));
+    assert(set_size(&frozen) == COUNT && set_size(&set) == COUNT + 1);
+    set_free(&frozen);
+
+    map_free(&map);
+    set_free(&set);
+    remove(IMAGE);
+    printf("map_snapshot: ok\n");
+    return 0;
+}
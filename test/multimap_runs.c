@@ -0,0 +1,117 @@
+#define UTOPIA_IMPLEMENTATION
+#define UTOPIA_HASH_UINT
+#include <utopia/multimap.h>
+#include <assert.h>
+#include <stdio.h>
+
+#define KEYS 64
+#define MAX 256
+
+static size_t model[KEYS][MAX];
+static size_t counts[KEYS];
+static char live[KEYS];
+
+static void runs_push(struct multimap* multimap, const size_t key)
+{
+    const size_t value = key * 100000 + counts[key];
+    assert(counts[key] < MAX);
+    multimap_push(multimap, &key, &value);
+    model[key][counts[key]++] = value;
+    live[key] = 1;
+}
+
+static void runs_remove(struct multimap* multimap, const size_t key)
+{
+    assert(multimap_remove(multimap, &key));
+    counts[key] = 0;
+    live[key] = 0;
+}
+
+static void runs_remove_value(struct multimap* multimap, const size_t key, const size_t index)
+{
+    assert(multimap_remove_value(multimap, &key, index));
+    memmove(model[key] + index, model[key] + index + 1, (--counts[key] - index) * sizeof(size_t));
+}
+
+static void runs_check(const struct multimap* multimap)
+{
+    size_t i, key, count, size = 0, total = 0;
+    for (key = 0; key < KEYS; ++key) {
+        const size_t* values = multimap_values(multimap, &key, &count);
+        if (!live[key]) {
+            assert(!values && !count);
+            continue;
+        }
+
+        assert(values && count == counts[key]);
+        for (i = 0; i < count; ++i) {
+            assert(values[i] == model[key][i]);
+        }
+        total += count;
+        ++size;
+    }
+
+    assert(multimap_size(multimap) == size && multimap_count(multimap) == total);
+}
+
+int main(void)
+{
+    size_t r, key;
+    struct multimap multimap = multimap_create(sizeof(size_t), sizeof(size_t));
+
+    for (r = 0; r < 40; ++r) {
+        for (key = 0; key < KEYS; ++key) {
+            if (!(r % (key % 5 + 1))) {
+                runs_push(&multimap, key);
+            }
+        }
+        if (r % 8 == 3) {
+            runs_check(&multimap);
+        }
+    }
+    for (r = 0; r < 20; ++r) {
+        runs_push(&multimap, KEYS - 1);
+    }
+    runs_check(&multimap);
+
+    for (key = 0; key < KEYS; key += 3) {
+        runs_remove(&multimap, key);
+    }
+    for (key = 1; key < KEYS; key += 3) {
+        runs_remove_value(&multimap, key, 0);
+        runs_remove_value(&multimap, key, counts[key] / 2);
+        runs_remove_value(&multimap, key, counts[key] - 1);
+    }
+    key = KEYS;
+    assert(!multimap_remove(&multimap, &key) && !multimap_remove_value(&multimap, &key, 0));
+    key = 1;
+    assert(!multimap_remove_value(&multimap, &key, counts[key]));
+    runs_check(&multimap);
+
+    multimap_compact(&multimap);
+    runs_check(&multimap);
+
+    for (r = 0; r < 10; ++r) {
+        for (key = 0; key < KEYS; key += 2) {
+            runs_push(&multimap, key);
+        }
+        runs_push(&multimap, 5);
+    }
+    runs_check(&multimap);
+
+    multimap_compact(&multimap);
+    runs_check(&multimap);
+    for (key = 0; key < KEYS; ++key) {
+        if (live[key]) {
+            runs_remove(&multimap, key);
+        }
+    }
+    multimap_compact(&multimap);
+    runs_check(&multimap);
+    runs_push(&multimap, 7);
+    runs_check(&multimap);
+
+    multimap_free(&multimap);
+    printf("multimap_runs: ok\n");
+    return 0;
+}
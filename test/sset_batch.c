@@ -0,0 +1,55 @@
+#define UTOPIA_IMPLEMENTATION
+#define UTOPIA_HASH_UINT
+#include <utopia/sset.h>
+#include <assert.h>
+#include <stdio.h>
+
+#define COUNT 200000
+#define DISTINCT 30011
+#define THREADS 6
+
+static void batch_check(const size_t* keys, const size_t threads)
+{
+    size_t i, key, pushed, serial_pushed;
+    char* inserted = malloc(COUNT), *serial_inserted = malloc(COUNT);
+    struct sset sset = sset_create(sizeof(size_t), 0), serial = sset_create(sizeof(size_t), 0);
+    for (key = 0; key < DISTINCT; key += 7) {
+        sset_push(&sset, &key);
+        sset_push(&serial, &key);
+    }
+
+    pushed = sset_push_batch(&sset, keys, COUNT, threads, inserted);
+    serial_pushed = sset_push_batch(&serial, keys, COUNT, 1, serial_inserted);
+    assert(pushed == serial_pushed && pushed == DISTINCT - (DISTINCT + 6) / 7);
+    assert(sset_size(&sset) == sset_size(&serial) && sset_size(&sset) == DISTINCT);
+    for (i = 0; i < COUNT; ++i) {
+        assert(inserted[i] == serial_inserted[i]);
+    }
+
+    for (key = 0; key < 2 * DISTINCT; ++key) {
+        assert(sset_search(&sset, &key) == sset_search(&serial, &key));
+        assert(sset_search(&sset, &key) == (key < DISTINCT));
+    }
+
+    sset_free(&sset);
+    sset_free(&serial);
+    free(inserted);
+    free(serial_inserted);
+}
+
+int main(void)
+{
+    size_t i, threads;
+    size_t* keys = malloc(COUNT * sizeof(size_t));
+    for (i = 0; i < COUNT; ++i) {
+        keys[i] = (i * 7919) % DISTINCT;
+    }
+
+    for (threads = 2; threads <= THREADS; ++threads) {
+        batch_check(keys, threads);
+    }
+
+    free(keys);
+    printf("sset_batch: ok\n");
+    return 0;
+}
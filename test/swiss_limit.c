@@ -0,0 +1,35 @@
+#define UTOPIA_IMPLEMENTATION
+#define UTOPIA_HASH_UINT
+#define UTOPIA_SWISS_MAX 100
+#include <utopia/swiss.h>
+#include <assert.h>
+#include <stdio.h>
+
+int main(void)
+{
+    size_t i;
+    struct swiss swiss = swiss_create(sizeof(size_t), sizeof(size_t));
+    for (i = 0; i < 2 * UTOPIA_SWISS_MAX; ++i) {
+        void* ptr = swiss_push(&swiss, &i, &i);
+        assert(!ptr == (i >= UTOPIA_SWISS_MAX));
+    }
+
+    assert(swiss_size(&swiss) == UTOPIA_SWISS_MAX);
+    for (i = 0; i < 2 * UTOPIA_SWISS_MAX; ++i) {
+        const size_t index = swiss_search(&swiss, &i);
+        assert(!!index == (i < UTOPIA_SWISS_MAX));
+        assert(!index || *(size_t*)swiss_value_at(&swiss, index - 1) == i);
+    }
+
+    swiss_resize(&swiss, 4 * UTOPIA_SWISS_MAX);
+    assert(swiss_capacity(&swiss) < 4 * UTOPIA_SWISS_MAX);
+    i = 3;
+    assert(swiss_remove(&swiss, &i));
+    i = UTOPIA_SWISS_MAX;
+    assert(swiss_push(&swiss, &i, &i) && swiss_search(&swiss, &i));
+    assert(!swiss_push(&swiss, &i, &i));
+
+    swiss_free(&swiss);
+    printf("swiss_limit: ok\n");
+    return 0;
+}
@@ -0,0 +1,47 @@
+#define UTOPIA_IMPLEMENTATION
+#include <utopia/table.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#define COUNT 1003
+
+int main(void)
+{
+    static const size_t widths[] = {1, 2, 3, 4, 8, 16, 32};
+    static const size_t distinct[] = {2, 4, 5, 16, 256};
+    size_t i, w, n, buffer[COUNT], rows[COUNT];
+    for (w = 0; w < sizeof(widths) / sizeof(widths[0]); ++w) {
+        const size_t mask = ((size_t)1 << widths[w]) - 1;
+        struct table table = table_create(sizeof(size_t));
+        table_push_index(&table, mask);
+        for (i = 1; i < COUNT; ++i) {
+            table_push_index(&table, (i * 2654435761UL) & mask);
+        }
+        assert(table_index_bits(&table) == widths[w]);
+        assert(table_indices(&table, NULL) == COUNT);
+        assert(table_indices(&table, buffer) == COUNT);
+        assert(buffer[0] == mask);
+        for (i = 1; i < COUNT; ++i) {
+            assert(buffer[i] == ((i * 2654435761UL) & mask));
+            assert(buffer[i] == table_index_at(&table, i));
+        }
+        table_free(&table);
+    }
+
+    for (w = 0; w < sizeof(distinct) / sizeof(distinct[0]); ++w) {
+        struct table table;
+        size_t* data;
+        for (i = 0; i < COUNT; ++i) {
+            rows[i] = (i * 7) % distinct[w];
+        }
+        table = table_compress(rows, sizeof(size_t), COUNT);
+        data = table_decompress(&table, &n);
+        assert(n == COUNT && !memcmp(data, rows, sizeof(rows)));
+        free(data);
+        table_free(&table);
+    }
+
+    printf("table_unpack: ok\n");
+    return 0;
+}
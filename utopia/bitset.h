@@ -0,0 +1,780 @@
+
+/*  Copyright (c) 2022 Eugenio Arteaga A.
+
+Permission is hereby granted, free of charge, to any 
+person obtaining a copy of this software and associated 
+documentation files (the "Software"), to deal in the 
+Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to 
+permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice 
+shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+#ifndef UTOPIA_BITSET_H
+#define UTOPIA_BITSET_H
+
+/*=======================================================
+**************  UTOPIA UTILITY LIBRARY   ****************
+Simple and easy generic containers & data structures in C 
+================================== @Eugenio Arteaga A. */
+
+/*****************************
+Compressed Integer Bitset
+*****************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef USTDDEF_H
+#define USTDDEF_H <stddef.h>
+#endif
+
+#include USTDDEF_H
+
+struct bitchunk {
+    size_t key;
+    size_t count;
+    size_t length;
+    size_t cap;
+    int type;
+    void* data;
+};
+
+struct bitset {
+    struct bitchunk* chunks;
+    size_t count;
+    size_t capacity;
+    size_t size;
+};
+
+struct bitset bitset_create(void);
+struct bitset bitset_copy(const struct bitset* bitset);
+int bitset_search(const struct bitset* bitset, const size_t value);
+int bitset_push(struct bitset* bitset, const size_t value);
+int bitset_remove(struct bitset* bitset, const size_t value);
+size_t bitset_size(const struct bitset* bitset);
+size_t bitset_bytes(const struct bitset* bitset);
+size_t bitset_next(const struct bitset* bitset, const size_t value);
+size_t bitset_to_array(const struct bitset* bitset, size_t* values);
+void bitset_optimize(struct bitset* bitset);
+struct bitset bitset_union(const struct bitset* a, const struct bitset* b);
+struct bitset bitset_intersect(const struct bitset* a, const struct bitset* b);
+struct bitset bitset_difference(const struct bitset* a, const struct bitset* b);
+struct bitset bitset_symmetric_difference(const struct bitset* a, const struct bitset* b);
+void bitset_free(struct bitset* bitset);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* UTOPIA_BITSET_H */
+
+#ifdef UTOPIA_IMPLEMENTATION
+
+#ifndef UTOPIA_BITSET_IMPLEMENTED
+#define UTOPIA_BITSET_IMPLEMENTED
+
+#ifndef USTDLIB_H 
+#define USTDLIB_H <stdlib.h>
+#endif
+
+#ifndef USTRING_H 
+#define USTRING_H <string.h>
+#endif
+
+#include USTDLIB_H
+#include USTRING_H
+
+#if defined(__SSE2__) && !defined(UTOPIA_NO_SIMD)
+#define UTOPIA_BITSET_SSE2
+#include <emmintrin.h>
+#endif
+
+/*****************************
+Compressed Integer Bitset
+*****************************/
+
+#define BITSET_ARRAY 0
+#define BITSET_BITMAP 1
+#define BITSET_RUN 2
+
+#define BITSET_KEEP_A 1
+#define BITSET_KEEP_BOTH 2
+#define BITSET_KEEP_B 4
+
+#define BITSET_CHUNK_SHIFT 16
+#define BITSET_CHUNK_MASK 0xFFFF
+#define BITSET_ARRAY_MAX 4096
+#define BITSET_WORD_BITS (sizeof(unsigned long) * 8)
+#define BITSET_WORDS (65536 / BITSET_WORD_BITS)
+#define BITSET_BITMAP_BYTES (BITSET_WORDS * sizeof(unsigned long))
+
+#define BITSET_BIT(words, i) (((words)[(i) / BITSET_WORD_BITS] >> ((i) % BITSET_WORD_BITS)) & 1)
+#define BITSET_SET(words, i) ((words)[(i) / BITSET_WORD_BITS] |= 1UL << ((i) % BITSET_WORD_BITS))
+#define BITSET_CLEAR(words, i) ((words)[(i) / BITSET_WORD_BITS] &= ~(1UL << ((i) % BITSET_WORD_BITS)))
+#define BITSET_CHUNK_BYTES(chunk) ((chunk)->cap * \
+    ((chunk)->type == BITSET_BITMAP ? sizeof(unsigned long) : sizeof(unsigned short)))
+
+#ifdef __GNUC__
+#define BITSET_POPCOUNT(x) ((size_t)__builtin_popcountl(x))
+#define BITSET_CTZ(x) ((size_t)__builtin_ctzl(x))
+#else
+#define BITSET_POPCOUNT(x) bitset_popcount(x)
+#define BITSET_CTZ(x) bitset_ctz(x)
+
+static size_t bitset_popcount(unsigned long x)
+{
+    x = x - ((x >> 1) & (~0UL / 3));
+    x = (x & (~0UL / 15 * 3)) + ((x >> 2) & (~0UL / 15 * 3));
+    x = (x + (x >> 4)) & (~0UL / 255 * 15);
+    return (size_t)((x * (~0UL / 255)) >> ((sizeof(unsigned long) - 1) * 8));
+}
+
+static size_t bitset_ctz(unsigned long x)
+{
+    size_t n = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        ++n;
+    }
+    return n;
+}
+#endif
+
+static size_t bitset_lower(const unsigned short* data, const size_t count, 
+                           const size_t step, const size_t value)
+{
+    size_t lo = 0, hi = count;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (data[mid * step] < value) {
+            lo = mid + 1;
+        }
+        else hi = mid;
+    }
+    return lo;
+}
+
+static size_t bitset_lower_chunk(const struct bitset* bitset, const size_t key)
+{
+    size_t lo = 0, hi = bitset->count;
+    if (hi && bitset->chunks[hi - 1].key < key) {
+        return hi;
+    }
+
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (bitset->chunks[mid].key < key) {
+            lo = mid + 1;
+        }
+        else hi = mid;
+    }
+    return lo;
+}
+
+static int bitchunk_contains(const struct bitchunk* chunk, const size_t low)
+{
+    size_t i;
+    const unsigned short* data = chunk->data;
+    if (chunk->type == BITSET_BITMAP) {
+        return (int)BITSET_BIT((const unsigned long*)chunk->data, low);
+    }
+
+    if (chunk->type == BITSET_ARRAY) {
+        i = bitset_lower(data, chunk->length, 1, low);
+        return i < chunk->length && data[i] == low;
+    }
+
+    i = bitset_lower(data, chunk->length / 2, 2, low + 1);
+    return i && data[2 * i - 1] >= low;
+}
+
+static void bitchunk_fill(const struct bitchunk* chunk, unsigned long* words)
+{
+    size_t i, v;
+    const unsigned short* data = chunk->data;
+    if (chunk->type == BITSET_BITMAP) {
+        memcpy(words, chunk->data, BITSET_BITMAP_BYTES);
+        return;
+    }
+
+    memset(words, 0, BITSET_BITMAP_BYTES);
+    if (chunk->type == BITSET_ARRAY) {
+        for (i = 0; i < chunk->length; ++i) {
+            BITSET_SET(words, data[i]);
+        }
+        return;
+    }
+
+    for (i = 0; i < chunk->length; i += 2) {
+        for (v = data[i]; v <= data[i + 1]; ++v) {
+            BITSET_SET(words, v);
+        }
+    }
+}
+
+static size_t bitchunk_extract(const unsigned long* words, unsigned short* values)
+{
+    size_t w, n = 0;
+    for (w = 0; w < BITSET_WORDS; ++w) {
+        unsigned long word = words[w];
+        while (word) {
+            values[n++] = (unsigned short)(w * BITSET_WORD_BITS + BITSET_CTZ(word));
+            word &= word - 1;
+        }
+    }
+    return n;
+}
+
+static void bitchunk_pack(struct bitchunk* chunk, const unsigned long* words, const size_t count)
+{
+    void* data;
+    if (count > BITSET_ARRAY_MAX) {
+        data = malloc(BITSET_BITMAP_BYTES);
+        memcpy(data, words, BITSET_BITMAP_BYTES);
+        chunk->type = BITSET_BITMAP;
+        chunk->length = BITSET_WORDS;
+    }
+    else {
+        data = malloc((count + !count) * sizeof(unsigned short));
+        chunk->type = BITSET_ARRAY;
+        chunk->length = bitchunk_extract(words, data);
+    }
+
+    free(chunk->data);
+    chunk->data = data;
+    chunk->cap = chunk->length;
+    chunk->count = count;
+}
+
+static void bitchunk_reserve(struct bitchunk* chunk, const size_t length)
+{
+    if (length > chunk->cap) {
+        chunk->cap = chunk->cap ? chunk->cap * 2 : 4;
+        chunk->cap = chunk->cap > BITSET_ARRAY_MAX ? BITSET_ARRAY_MAX : chunk->cap;
+        chunk->cap = chunk->cap < length ? length : chunk->cap;
+        chunk->data = realloc(chunk->data, chunk->cap * sizeof(unsigned short));
+    }
+}
+
+static int bitchunk_push_run(struct bitchunk* chunk, const size_t low)
+{
+    unsigned short* data = chunk->data;
+    const size_t runs = chunk->length / 2;
+    const size_t i = bitset_lower(data, runs, 2, low + 1);
+    int prev, next;
+    if (i && data[2 * i - 1] >= low) {
+        return 0;
+    }
+
+    prev = i && (size_t)data[2 * i - 1] + 1 == low;
+    next = i < runs && (size_t)data[2 * i] == low + 1;
+    if (prev && next) {
+        data[2 * i - 1] = data[2 * i + 1];
+        memmove(data + 2 * i, data + 2 * i + 2, (runs - i - 1) * 2 * sizeof(unsigned short));
+        chunk->length -= 2;
+    }
+    else if (prev) {
+        data[2 * i - 1] = (unsigned short)low;
+    }
+    else if (next) {
+        data[2 * i] = (unsigned short)low;
+    }
+    else {
+        bitchunk_reserve(chunk, chunk->length + 2);
+        data = chunk->data;
+        memmove(data + 2 * i + 2, data + 2 * i, (runs - i) * 2 * sizeof(unsigned short));
+        data[2 * i] = data[2 * i + 1] = (unsigned short)low;
+        chunk->length += 2;
+    }
+
+    ++chunk->count;
+    if (chunk->length >= chunk->count || 2 * chunk->length >= BITSET_BITMAP_BYTES) {
+        unsigned long* words = malloc(BITSET_BITMAP_BYTES);
+        bitchunk_fill(chunk, words);
+        bitchunk_pack(chunk, words, chunk->count);
+        free(words);
+    }
+    return 1;
+}
+
+static int bitchunk_push(struct bitchunk* chunk, const size_t low)
+{
+    size_t i;
+    unsigned short* data;
+    if (chunk->type == BITSET_BITMAP) {
+        unsigned long* words = chunk->data;
+        if (BITSET_BIT(words, low)) {
+            return 0;
+        }
+        BITSET_SET(words, low);
+        ++chunk->count;
+        return 1;
+    }
+
+    if (chunk->type == BITSET_RUN) {
+        return bitchunk_push_run(chunk, low);
+    }
+
+    data = chunk->data;
+    i = bitset_lower(data, chunk->length, 1, low);
+    if (i < chunk->length && data[i] == low) {
+        return 0;
+    }
+
+    if (chunk->count == BITSET_ARRAY_MAX) {
+        unsigned long* words = malloc(BITSET_BITMAP_BYTES);
+        bitchunk_fill(chunk, words);
+        free(chunk->data);
+        chunk->data = words;
+        chunk->type = BITSET_BITMAP;
+        chunk->length = chunk->cap = BITSET_WORDS;
+        return bitchunk_push(chunk, low);
+    }
+
+    bitchunk_reserve(chunk, chunk->length + 1);
+    data = chunk->data;
+    memmove(data + i + 1, data + i, (chunk->length - i) * sizeof(unsigned short));
+    data[i] = (unsigned short)low;
+    ++chunk->length;
+    ++chunk->count;
+    return 1;
+}
+
+static int bitchunk_remove(struct bitchunk* chunk, const size_t low)
+{
+    size_t i;
+    unsigned short* data;
+    if (!bitchunk_contains(chunk, low)) {
+        return 0;
+    }
+
+    if (chunk->type == BITSET_RUN) {
+        unsigned long* words = malloc(BITSET_BITMAP_BYTES);
+        bitchunk_fill(chunk, words);
+        bitchunk_pack(chunk, words, chunk->count);
+        free(words);
+    }
+
+    if (chunk->type == BITSET_BITMAP) {
+        BITSET_CLEAR((unsigned long*)chunk->data, low);
+        if (--chunk->count <= BITSET_ARRAY_MAX) {
+            bitchunk_pack(chunk, chunk->data, chunk->count);
+        }
+        return 1;
+    }
+
+    data = chunk->data;
+    i = bitset_lower(data, chunk->length, 1, low);
+    memmove(data + i, data + i + 1, (chunk->length - i - 1) * sizeof(unsigned short));
+    --chunk->length;
+    --chunk->count;
+    return 1;
+}
+
+static size_t bitchunk_next(const struct bitchunk* chunk, const size_t low)
+{
+    size_t i;
+    const unsigned short* data = chunk->data;
+    if (chunk->type == BITSET_BITMAP) {
+        const unsigned long* words = chunk->data;
+        unsigned long word;
+        i = low / BITSET_WORD_BITS;
+        word = words[i] & (~0UL << (low % BITSET_WORD_BITS));
+        while (!word && ++i < BITSET_WORDS) {
+            word = words[i];
+        }
+        return word ? i * BITSET_WORD_BITS + BITSET_CTZ(word) + 1 : 0;
+    }
+
+    if (chunk->type == BITSET_ARRAY) {
+        i = bitset_lower(data, chunk->length, 1, low);
+        return i < chunk->length ? (size_t)data[i] + 1 : 0;
+    }
+
+    i = bitset_lower(data, chunk->length / 2, 2, low + 1);
+    if (i && data[2 * i - 1] >= low) {
+        return low + 1;
+    }
+    return 2 * i < chunk->length ? (size_t)data[2 * i] + 1 : 0;
+}
+
+static void bitchunk_copy(struct bitchunk* dst, const struct bitchunk* src)
+{
+    *dst = *src;
+    dst->data = malloc(BITSET_CHUNK_BYTES(src) + 1);
+    memcpy(dst->data, src->data, BITSET_CHUNK_BYTES(src));
+}
+
+static size_t bitchunk_combine(unsigned long* wa, const unsigned long* wb, const unsigned long ma,
+                               const unsigned long mboth, const unsigned long mb)
+{
+    size_t i, n = 0;
+#ifdef UTOPIA_BITSET_SSE2
+    const __m128i ka = _mm_set1_epi32(ma ? -1 : 0);
+    const __m128i kboth = _mm_set1_epi32(mboth ? -1 : 0);
+    const __m128i kb = _mm_set1_epi32(mb ? -1 : 0);
+    for (i = 0; i < BITSET_WORDS; i += sizeof(__m128i) / sizeof(unsigned long)) {
+        const __m128i x = _mm_loadu_si128((const __m128i*)(wa + i));
+        const __m128i y = _mm_loadu_si128((const __m128i*)(wb + i));
+        __m128i r = _mm_and_si128(_mm_and_si128(x, y), kboth);
+        r = _mm_or_si128(r, _mm_and_si128(_mm_andnot_si128(y, x), ka));
+        r = _mm_or_si128(r, _mm_and_si128(_mm_andnot_si128(x, y), kb));
+        _mm_storeu_si128((__m128i*)(wa + i), r);
+    }
+
+    for (i = 0; i < BITSET_WORDS; ++i) {
+        n += BITSET_POPCOUNT(wa[i]);
+    }
+#else
+    for (i = 0; i < BITSET_WORDS; ++i) {
+        const unsigned long x = wa[i], y = wb[i];
+        wa[i] = (x & y & mboth) | (x & ~y & ma) | (~x & y & mb);
+        n += BITSET_POPCOUNT(wa[i]);
+    }
+#endif
+    return n;
+}
+
+static void bitchunk_merge(struct bitchunk* out, const struct bitchunk* a, const struct bitchunk* b, 
+                           const int keep, unsigned long* wa, unsigned long* wb)
+{
+    size_t i, j, n = 0;
+    const unsigned long ma = keep & BITSET_KEEP_A ? ~0UL : 0UL;
+    const unsigned long mboth = keep & BITSET_KEEP_BOTH ? ~0UL : 0UL;
+    const unsigned long mb = keep & BITSET_KEEP_B ? ~0UL : 0UL;
+    
+    out->key = a->key;
+    out->data = NULL;
+    out->cap = 0;
+    if (a->type == BITSET_ARRAY && b->type == BITSET_ARRAY) {
+        const unsigned short* x = a->data, *y = b->data;
+        unsigned short* data = malloc((a->length + b->length + 1) * sizeof(unsigned short));
+        for (i = 0, j = 0; i < a->length || j < b->length;) {
+            if (j == b->length || (i < a->length && x[i] < y[j])) {
+                if (ma) {
+                    data[n++] = x[i];
+                }
+                ++i;
+            }
+            else if (i == a->length || y[j] < x[i]) {
+                if (mb) {
+                    data[n++] = y[j];
+                }
+                ++j;
+            }
+            else {
+                if (mboth) {
+                    data[n++] = x[i];
+                }
+                ++i;
+                ++j;
+            }
+        }
+
+        if (n > BITSET_ARRAY_MAX) {
+            memset(wa, 0, BITSET_BITMAP_BYTES);
+            for (i = 0; i < n; ++i) {
+                BITSET_SET(wa, data[i]);
+            }
+            free(data);
+            bitchunk_pack(out, wa, n);
+            return;
+        }
+
+        out->type = BITSET_ARRAY;
+        out->data = data;
+        out->length = out->cap = out->count = n;
+        return;
+    }
+
+    if (keep == BITSET_KEEP_BOTH && (a->type == BITSET_ARRAY || b->type == BITSET_ARRAY)) {
+        const struct bitchunk* small = a->type == BITSET_ARRAY ? a : b;
+        const struct bitchunk* large = small == a ? b : a;
+        const unsigned short* x = small->data;
+        unsigned short* data = malloc((small->length + 1) * sizeof(unsigned short));
+        for (i = 0; i < small->length; ++i) {
+            if (bitchunk_contains(large, x[i])) {
+                data[n++] = x[i];
+            }
+        }
+
+        out->type = BITSET_ARRAY;
+        out->data = data;
+        out->length = out->cap = out->count = n;
+        return;
+    }
+
+    bitchunk_fill(a, wa);
+    bitchunk_fill(b, wb);
+    bitchunk_pack(out, wa, bitchunk_combine(wa, wb, ma, mboth, mb));
+}
+
+static struct bitset bitset_algebra(const struct bitset* a, const struct bitset* b, const int keep)
+{
+    size_t i = 0, j = 0;
+    struct bitset bitset = bitset_create();
+    unsigned long* wa = malloc(BITSET_BITMAP_BYTES);
+    unsigned long* wb = malloc(BITSET_BITMAP_BYTES);
+    
+    bitset.capacity = a->count + b->count;
+    bitset.chunks = bitset.capacity ? malloc(bitset.capacity * sizeof(struct bitchunk)) : NULL;
+    while (i < a->count || j < b->count) {
+        struct bitchunk* out = bitset.chunks + bitset.count;
+        if (j == b->count || (i < a->count && a->chunks[i].key < b->chunks[j].key)) {
+            if (!(keep & BITSET_KEEP_A)) {
+                ++i;
+                continue;
+            }
+            bitchunk_copy(out, a->chunks + i++);
+        }
+        else if (i == a->count || b->chunks[j].key < a->chunks[i].key) {
+            if (!(keep & BITSET_KEEP_B)) {
+                ++j;
+                continue;
+            }
+            bitchunk_copy(out, b->chunks + j++);
+        }
+        else {
+            bitchunk_merge(out, a->chunks + i++, b->chunks + j++, keep, wa, wb);
+            if (!out->count) {
+                free(out->data);
+                continue;
+            }
+        }
+
+        bitset.size += out->count;
+        ++bitset.count;
+    }
+
+    free(wa);
+    free(wb);
+    return bitset;
+}
+
+struct bitset bitset_create(void)
+{
+    struct bitset bitset;
+    bitset.chunks = NULL;
+    bitset.count = 0;
+    bitset.capacity = 0;
+    bitset.size = 0;
+    return bitset;
+}
+
+struct bitset bitset_copy(const struct bitset* bitset)
+{
+    size_t i;
+    struct bitset copy = *bitset;
+    if (bitset->capacity) {
+        copy.chunks = malloc(bitset->capacity * sizeof(struct bitchunk));
+        for (i = 0; i < bitset->count; ++i) {
+            bitchunk_copy(copy.chunks + i, bitset->chunks + i);
+        }
+    }
+    return copy;
+}
+
+int bitset_search(const struct bitset* bitset, const size_t value)
+{
+    const size_t key = value >> BITSET_CHUNK_SHIFT;
+    const size_t i = bitset_lower_chunk(bitset, key);
+    if (i < bitset->count && bitset->chunks[i].key == key) {
+        return bitchunk_contains(bitset->chunks + i, value & BITSET_CHUNK_MASK);
+    }
+    return 0;
+}
+
+int bitset_push(struct bitset* bitset, const size_t value)
+{
+    const size_t key = value >> BITSET_CHUNK_SHIFT;
+    const size_t i = bitset_lower_chunk(bitset, key);
+    struct bitchunk* chunk = bitset->chunks + i;
+    if (i == bitset->count || chunk->key != key) {
+        if (bitset->count == bitset->capacity) {
+            bitset->capacity = bitset->capacity ? bitset->capacity * 2 : 4;
+            bitset->chunks = realloc(bitset->chunks, bitset->capacity * sizeof(struct bitchunk));
+        }
+
+        chunk = bitset->chunks + i;
+        memmove(chunk + 1, chunk, (bitset->count - i) * sizeof(struct bitchunk));
+        chunk->key = key;
+        chunk->count = 0;
+        chunk->length = 0;
+        chunk->cap = 0;
+        chunk->type = BITSET_ARRAY;
+        chunk->data = NULL;
+        ++bitset->count;
+    }
+
+    if (bitchunk_push(chunk, value & BITSET_CHUNK_MASK)) {
+        ++bitset->size;
+        return 1;
+    }
+    return 0;
+}
+
+int bitset_remove(struct bitset* bitset, const size_t value)
+{
+    const size_t key = value >> BITSET_CHUNK_SHIFT;
+    const size_t i = bitset_lower_chunk(bitset, key);
+    struct bitchunk* chunk = bitset->chunks + i;
+    if (i == bitset->count || chunk->key != key || !bitchunk_remove(chunk, value & BITSET_CHUNK_MASK)) {
+        return 0;
+    }
+
+    if (!chunk->count) {
+        free(chunk->data);
+        memmove(chunk, chunk + 1, (--bitset->count - i) * sizeof(struct bitchunk));
+    }
+
+    --bitset->size;
+    return 1;
+}
+
+size_t bitset_size(const struct bitset* bitset)
+{
+    return bitset->size;
+}
+
+size_t bitset_bytes(const struct bitset* bitset)
+{
+    size_t i, bytes = bitset->capacity * sizeof(struct bitchunk);
+    for (i = 0; i < bitset->count; ++i) {
+        bytes += BITSET_CHUNK_BYTES(bitset->chunks + i);
+    }
+    return bytes;
+}
+
+size_t bitset_next(const struct bitset* bitset, const size_t value)
+{
+    const size_t key = value >> BITSET_CHUNK_SHIFT;
+    size_t i = bitset_lower_chunk(bitset, key);
+    for (; i < bitset->count; ++i) {
+        const struct bitchunk* chunk = bitset->chunks + i;
+        const size_t next = bitchunk_next(chunk, chunk->key == key ? value & BITSET_CHUNK_MASK : 0);
+        if (next) {
+            return ((chunk->key << BITSET_CHUNK_SHIFT) | (next - 1)) + 1;
+        }
+    }
+    return 0;
+}
+
+size_t bitset_to_array(const struct bitset* bitset, size_t* values)
+{
+    size_t i, j, v, n = 0;
+    for (i = 0; i < bitset->count; ++i) {
+        const struct bitchunk* chunk = bitset->chunks + i;
+        const unsigned short* data = chunk->data;
+        const size_t base = chunk->key << BITSET_CHUNK_SHIFT;
+        if (chunk->type == BITSET_BITMAP) {
+            const unsigned long* words = chunk->data;
+            for (j = 0; j < BITSET_WORDS; ++j) {
+                unsigned long word = words[j];
+                while (word) {
+                    values[n++] = base + j * BITSET_WORD_BITS + BITSET_CTZ(word);
+                    word &= word - 1;
+                }
+            }
+        }
+        else if (chunk->type == BITSET_ARRAY) {
+            for (j = 0; j < chunk->length; ++j) {
+                values[n++] = base + data[j];
+            }
+        }
+        else {
+            for (j = 0; j < chunk->length; j += 2) {
+                for (v = data[j]; v <= data[j + 1]; ++v) {
+                    values[n++] = base + v;
+                }
+            }
+        }
+    }
+    return n;
+}
+
+void bitset_optimize(struct bitset* bitset)
+{
+    size_t i, j, runs;
+    unsigned long* words = malloc(BITSET_BITMAP_BYTES);
+    unsigned short* values = malloc(65536 * sizeof(unsigned short));
+    for (i = 0; i < bitset->count; ++i) {
+        struct bitchunk* chunk = bitset->chunks + i;
+        unsigned long carry = 0;
+        bitchunk_fill(chunk, words);
+        for (runs = 0, j = 0; j < BITSET_WORDS; ++j) {
+            runs += BITSET_POPCOUNT(words[j] & ~((words[j] << 1) | carry));
+            carry = words[j] >> (BITSET_WORD_BITS - 1);
+        }
+
+        if (4 * runs < 2 * chunk->count && 4 * runs < BITSET_BITMAP_BYTES) {
+            unsigned short* data = malloc(2 * runs * sizeof(unsigned short));
+            const size_t n = bitchunk_extract(words, values);
+            for (runs = 0, j = 0; j < n; ++j) {
+                if (!j || values[j] != values[j - 1] + 1) {
+                    data[2 * runs++] = values[j];
+                }
+                data[2 * runs - 1] = values[j];
+            }
+
+            free(chunk->data);
+            chunk->data = data;
+            chunk->type = BITSET_RUN;
+            chunk->length = chunk->cap = 2 * runs;
+        }
+        else bitchunk_pack(chunk, words, chunk->count);
+    }
+
+    free(values);
+    free(words);
+}
+
+struct bitset bitset_union(const struct bitset* a, const struct bitset* b)
+{
+    return bitset_algebra(a, b, BITSET_KEEP_A | BITSET_KEEP_BOTH | BITSET_KEEP_B);
+}
+
+struct bitset bitset_intersect(const struct bitset* a, const struct bitset* b)
+{
+    return bitset_algebra(a, b, BITSET_KEEP_BOTH);
+}
+
+struct bitset bitset_difference(const struct bitset* a, const struct bitset* b)
+{
+    return bitset_algebra(a, b, BITSET_KEEP_A);
+}
+
+struct bitset bitset_symmetric_difference(const struct bitset* a, const struct bitset* b)
+{
+    return bitset_algebra(a, b, BITSET_KEEP_A | BITSET_KEEP_B);
+}
+
+void bitset_free(struct bitset* bitset)
+{
+    size_t i;
+    for (i = 0; i < bitset->count; ++i) {
+        free(bitset->chunks[i].data);
+    }
+
+    free(bitset->chunks);
+    bitset->chunks = NULL;
+    bitset->count = 0;
+    bitset->capacity = 0;
+    bitset->size = 0;
+}
+
+#endif /* UTOPIA_BITSET_IMPLEMENTED */
+#endif /* UTOPIA_IMPLEMENTATION */
@@ -0,0 +1,576 @@
+
+/*  Copyright (c) 2022 Eugenio Arteaga A.
+
+Permission is hereby granted, free of charge, to any 
+person obtaining a copy of this software and associated 
+documentation files (the "Software"), to deal in the 
+Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to 
+permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice 
+shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+#ifndef UTOPIA_CMAP_H
+#define UTOPIA_CMAP_H
+
+/*=======================================================
+**************  UTOPIA UTILITY LIBRARY   ****************
+Simple and easy generic containers & data structures in C 
+================================== @Eugenio Arteaga A. */
+
+/**************************************
+Concurrent <Key, Value> Hash Map
+Requires pthreads and GCC/Clang atomics
+**************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef USTDDEF_H
+#define USTDDEF_H <stddef.h>
+#endif
+
+#include USTDDEF_H
+#include <pthread.h>
+
+struct cmapnode {
+    struct cmapnode* next;
+    size_t hash;
+};
+
+struct cmaptable {
+    size_t mod;
+    struct cmapnode* buckets[1];
+};
+
+struct cmapslot {
+    size_t count[2];
+    char pad[64 - 2 * sizeof(size_t)];
+};
+
+struct cmap {
+    struct cmaptable* table;
+    pthread_mutex_t* locks;
+    struct cmapslot* readers;
+    void** garbage;
+    size_t garbage_size;
+    size_t garbage_cap;
+    size_t key_bytes;
+    size_t value_bytes;
+    size_t size;
+    size_t epoch;
+    size_t stripes;
+    size_t (*func)(const void*);
+    int (*eq)(const void*, const void*);
+};
+
+#define _cmapnode_key(node) ((char*)((node) + 1))
+#define _cmapnode_value(cmap, node) (_cmapnode_key(node) + (cmap)->key_bytes)
+
+struct cmap cmap_create(const size_t key_size, const size_t value_size);
+struct cmap cmap_reserve(const size_t key_size, const size_t value_size, const size_t reserve);
+int cmap_search(struct cmap* cmap, const void* key, void* value);
+/* overloading the hash replaces the default strcmp equality with a memcmp of
+the key bytes, set cmap_overload_eq (e.g. equal_string) for char* keys */
+void cmap_overload(struct cmap* cmap, size_t (*hash_func)(const void*));
+void cmap_overload_eq(struct cmap* cmap, int (*eq_func)(const void*, const void*));
+size_t cmap_size(const struct cmap* cmap);
+size_t cmap_capacity(struct cmap* cmap);
+size_t cmap_key_bytes(const struct cmap* cmap);
+size_t cmap_value_bytes(const struct cmap* cmap);
+void cmap_resize(struct cmap* cmap, const size_t size);
+void cmap_push(struct cmap* cmap, const void* key, const void* value);
+int cmap_push_if(struct cmap* cmap, const void* key, const void* value);
+int cmap_remove(struct cmap* cmap, const void* key);
+void cmap_free(struct cmap* cmap);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* UTOPIA_CMAP_H */
+
+#ifdef UTOPIA_IMPLEMENTATION
+
+#ifndef UTOPIA_CMAP_IMPLEMENTED
+#define UTOPIA_CMAP_IMPLEMENTED
+
+#ifndef USTDLIB_H 
+#define USTDLIB_H <stdlib.h>
+#endif
+
+#ifndef USTRING_H 
+#define USTRING_H <string.h>
+#endif
+
+#include USTDLIB_H
+#include USTRING_H
+#include <sched.h>
+
+#ifndef UTOPIA_CMAP_STRIPES
+#define UTOPIA_CMAP_STRIPES 64
+#endif
+
+#ifndef UTOPIA_CMAP_READERS
+#define UTOPIA_CMAP_READERS 64
+#endif
+
+#ifndef UTOPIA_CMAP_GARBAGE
+#define UTOPIA_CMAP_GARBAGE 256
+#endif
+
+#define CMAP_LOAD(ptr) __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define CMAP_STORE(ptr, val) __atomic_store_n(ptr, val, __ATOMIC_RELEASE)
+
+/* Hashable Implementation */
+
+#ifndef UTOPIA_HASHABLE_IMPLEMENTED
+#define UTOPIA_HASHABLE_IMPLEMENTED
+
+#ifndef UTOPIA_HASH_SIZE
+#define UTOPIA_HASH_SIZE 32
+#endif
+
+static void* memdup(const void* src, size_t size)
+{
+    void* dup = malloc(size);
+    memcpy(dup, src, size);
+    return dup;
+}
+
+static size_t hash_default(const void* key)
+{
+#ifndef UTOPIA_HASH_UINT
+    int c;
+    size_t hash = 5381;
+    const unsigned char* str = *(unsigned char**)key;
+    while ((c = *str++)) {
+        hash = ((hash << 5) + hash) + c;
+    }
+    return hash;
+#else
+    size_t x = *(size_t*)key;
+    x = ((x >> 16) ^ x) * 0x45d9f3b;
+    x = ((x >> 16) ^ x) * 0x45d9f3b;
+    return (x >> 16) ^ x;
+#endif
+}
+
+#endif /* UTOPIA_HASHABLE_IMPLEMENTED */
+
+/* Equality Implementation */
+
+#ifndef UTOPIA_EQUALS_IMPLEMENTED
+#define UTOPIA_EQUALS_IMPLEMENTED
+
+static int equal_default(const void* a, const void* b)
+{
+#ifndef UTOPIA_HASH_UINT
+    return !strcmp(*(char**)a, *(char**)b);
+#else
+    return *(size_t*)a == *(size_t*)b;
+#endif
+}
+
+#endif /* UTOPIA_EQUALS_IMPLEMENTED */
+
+/* Epoch Reclamation Implementation */
+
+static size_t cmap_reader_slot(void)
+{
+    size_t id = 0;
+    pthread_t self = pthread_self();
+    memcpy(&id, &self, sizeof(self) < sizeof(id) ? sizeof(self) : sizeof(id));
+    id ^= id >> 17;
+    id *= 0x45d9f3b;
+    return (id ^ (id >> 16)) % UTOPIA_CMAP_READERS;
+}
+
+static size_t cmap_enter(struct cmap* cmap, const size_t slot)
+{
+    size_t* counts = cmap->readers[slot].count;
+    while (1) {
+        const size_t epoch = CMAP_LOAD(&cmap->epoch) & 1;
+        __atomic_fetch_add(counts + epoch, 1, __ATOMIC_SEQ_CST);
+        if ((__atomic_load_n(&cmap->epoch, __ATOMIC_SEQ_CST) & 1) == epoch) {
+            return epoch;
+        }
+        __atomic_fetch_sub(counts + epoch, 1, __ATOMIC_RELEASE);
+    }
+}
+
+static void cmap_leave(struct cmap* cmap, const size_t slot, const size_t epoch)
+{
+    __atomic_fetch_sub(cmap->readers[slot].count + epoch, 1, __ATOMIC_RELEASE);
+}
+
+/* caller must hold the resize lock */
+static void cmap_synchronize(struct cmap* cmap)
+{
+    size_t i;
+    const size_t epoch = __atomic_fetch_add(&cmap->epoch, 1, __ATOMIC_SEQ_CST) & 1;
+    for (i = 0; i < UTOPIA_CMAP_READERS; ++i) {
+        while (__atomic_load_n(cmap->readers[i].count + epoch, __ATOMIC_SEQ_CST)) {
+            sched_yield();
+        }
+    }
+}
+
+static void cmap_reclaim(struct cmap* cmap)
+{
+    size_t i, size;
+    void** garbage;
+    pthread_mutex_t* resize = cmap->locks + cmap->stripes;
+    pthread_mutex_t* collect = resize + 1;
+
+    pthread_mutex_lock(resize);
+    pthread_mutex_lock(collect);
+    garbage = cmap->garbage;
+    size = cmap->garbage_size;
+    cmap->garbage = NULL;
+    cmap->garbage_size = 0;
+    cmap->garbage_cap = 0;
+    pthread_mutex_unlock(collect);
+
+    cmap_synchronize(cmap);
+    pthread_mutex_unlock(resize);
+
+    for (i = 0; i < size; ++i) {
+        free(garbage[i]);
+    }
+    free(garbage);
+}
+
+static void cmap_retire(struct cmap* cmap, void* ptr)
+{
+    size_t size;
+    pthread_mutex_t* collect = cmap->locks + cmap->stripes + 1;
+
+    pthread_mutex_lock(collect);
+    if (cmap->garbage_size == cmap->garbage_cap) {
+        cmap->garbage_cap = cmap->garbage_cap * 2 + !cmap->garbage_cap * UTOPIA_CMAP_GARBAGE;
+        cmap->garbage = realloc(cmap->garbage, cmap->garbage_cap * sizeof(void*));
+    }
+    cmap->garbage[cmap->garbage_size++] = ptr;
+    size = cmap->garbage_size;
+    pthread_mutex_unlock(collect);
+
+    if (size >= UTOPIA_CMAP_GARBAGE) {
+        cmap_reclaim(cmap);
+    }
+}
+
+/* Table Implementation */
+
+static struct cmaptable* cmaptable_create(const size_t size)
+{
+    size_t mod = UTOPIA_CMAP_STRIPES;
+    struct cmaptable* table;
+    while (mod < size) {
+        mod <<= 1;
+    }
+
+    table = calloc(1, sizeof(struct cmaptable) + (mod - 1) * sizeof(struct cmapnode*));
+    table->mod = mod;
+    return table;
+}
+
+static struct cmapnode* cmapnode_create(const struct cmap* cmap, const void* key,
+                                        const void* value, const size_t hash)
+{
+    struct cmapnode* node = malloc(sizeof(struct cmapnode) + cmap->key_bytes + cmap->value_bytes);
+    node->next = NULL;
+    node->hash = hash;
+    memcpy(_cmapnode_key(node), key, cmap->key_bytes);
+    memcpy(_cmapnode_value(cmap, node), value, cmap->value_bytes);
+    return node;
+}
+
+static struct cmapnode** cmap_bucket(const struct cmaptable* table, const size_t hash)
+{
+    return (struct cmapnode**)table->buckets + (hash & (table->mod - 1));
+}
+
+static struct cmapnode* cmap_find(const struct cmap* cmap, const struct cmaptable* table,
+                                const void* key, const size_t hash)
+{
+    struct cmapnode* node = CMAP_LOAD(cmap_bucket(table, hash));
+    while (node) {
+        if (node->hash == hash) {
+            const char* k = _cmapnode_key(node);
+            if (cmap->eq ? cmap->eq(k, key) : !memcmp(k, key, cmap->key_bytes)) {
+                return node;
+            }
+        }
+        node = CMAP_LOAD(&node->next);
+    }
+    return NULL;
+}
+
+/* caller must hold the resize lock */
+static void cmap_rebuild(struct cmap* cmap, const size_t size)
+{
+    size_t i, count;
+    struct cmapnode* node, *next;
+    struct cmaptable* table, *old = cmap->table;
+
+    for (i = 0; i < cmap->stripes; ++i) {
+        pthread_mutex_lock(cmap->locks + i);
+    }
+
+    count = CMAP_LOAD(&cmap->size);
+    table = cmaptable_create(size > count ? size : count);
+    for (i = 0; i < old->mod; ++i) {
+        for (node = old->buckets[i]; node; node = node->next) {
+            struct cmapnode** bucket = cmap_bucket(table, node->hash);
+            struct cmapnode* copy = memdup(node, sizeof(struct cmapnode) + cmap->key_bytes + cmap->value_bytes);
+            copy->next = *bucket;
+            *bucket = copy;
+        }
+    }
+
+    CMAP_STORE(&cmap->table, table);
+    for (i = 0; i < cmap->stripes; ++i) {
+        pthread_mutex_unlock(cmap->locks + i);
+    }
+
+    cmap_synchronize(cmap);
+    for (i = 0; i < old->mod; ++i) {
+        for (node = old->buckets[i]; node; node = next) {
+            next = node->next;
+            free(node);
+        }
+    }
+    free(old);
+}
+
+static void cmap_grow(struct cmap* cmap)
+{
+    pthread_mutex_t* resize = cmap->locks + cmap->stripes;
+    pthread_mutex_lock(resize);
+    if (CMAP_LOAD(&cmap->size) > cmap->table->mod) {
+        cmap_rebuild(cmap, cmap->table->mod * 2);
+    }
+    pthread_mutex_unlock(resize);
+}
+
+/**************************************
+Concurrent <Key, Value> Hash Map
+**************************************/
+
+struct cmap cmap_create(const size_t key_size, const size_t value_size)
+{
+    return cmap_reserve(key_size, value_size, UTOPIA_HASH_SIZE);
+}
+
+struct cmap cmap_reserve(const size_t key_size, const size_t value_size, const size_t reserve)
+{
+    size_t i;
+    struct cmap cmap;
+    cmap.stripes = UTOPIA_CMAP_STRIPES;
+    cmap.table = cmaptable_create(reserve);
+    cmap.locks = malloc((cmap.stripes + 2) * sizeof(pthread_mutex_t));
+    cmap.readers = calloc(UTOPIA_CMAP_READERS, sizeof(struct cmapslot));
+    cmap.garbage = NULL;
+    cmap.garbage_size = 0;
+    cmap.garbage_cap = 0;
+    cmap.key_bytes = key_size + !key_size;
+    cmap.value_bytes = value_size + !value_size;
+    cmap.size = 0;
+    cmap.epoch = 0;
+    cmap.func = &hash_default;
+    cmap.eq = &equal_default;
+    
+    for (i = 0; i < cmap.stripes + 2; ++i) {
+        pthread_mutex_init(cmap.locks + i, NULL);
+    }
+
+    return cmap;
+}
+
+void cmap_overload(struct cmap* cmap, size_t (*func)(const void*))
+{
+    cmap->func = func;
+    if (cmap->eq == &equal_default) {
+        cmap->eq = NULL;
+    }
+}
+
+void cmap_overload_eq(struct cmap* cmap, int (*eq)(const void*, const void*))
+{
+    cmap->eq = eq;
+}
+
+size_t cmap_size(const struct cmap* cmap)
+{
+    return CMAP_LOAD(&cmap->size);
+}
+
+size_t cmap_capacity(struct cmap* cmap)
+{
+    size_t mod;
+    const size_t slot = cmap_reader_slot();
+    const size_t epoch = cmap_enter(cmap, slot);
+    mod = CMAP_LOAD(&cmap->table)->mod;
+    cmap_leave(cmap, slot, epoch);
+    return mod;
+}
+
+size_t cmap_key_bytes(const struct cmap* cmap)
+{
+    return cmap->key_bytes;
+}
+
+size_t cmap_value_bytes(const struct cmap* cmap)
+{
+    return cmap->value_bytes;
+}
+
+int cmap_search(struct cmap* cmap, const void* key, void* value)
+{
+    const struct cmapnode* node;
+    const size_t hash = cmap->func(key);
+    const size_t slot = cmap_reader_slot();
+    const size_t epoch = cmap_enter(cmap, slot);
+
+    node = cmap_find(cmap, CMAP_LOAD(&cmap->table), key, hash);
+    if (node && value) {
+        memcpy(value, _cmapnode_value(cmap, node), cmap->value_bytes);
+    }
+
+    cmap_leave(cmap, slot, epoch);
+    return node != NULL;
+}
+
+void cmap_resize(struct cmap* cmap, const size_t size)
+{
+    pthread_mutex_t* resize = cmap->locks + cmap->stripes;
+    pthread_mutex_lock(resize);
+    cmap_rebuild(cmap, size);
+    pthread_mutex_unlock(resize);
+}
+
+void cmap_push(struct cmap* cmap, const void* key, const void* value)
+{
+    size_t mod;
+    const size_t hash = cmap->func(key);
+    struct cmapnode* node = cmapnode_create(cmap, key, value, hash);
+    pthread_mutex_t* lock = cmap->locks + (hash & (cmap->stripes - 1));
+    struct cmapnode** bucket;
+
+    pthread_mutex_lock(lock);
+    mod = cmap->table->mod;
+    bucket = cmap_bucket(cmap->table, hash);
+    node->next = *bucket;
+    CMAP_STORE(bucket, node);
+    pthread_mutex_unlock(lock);
+
+    if (__atomic_add_fetch(&cmap->size, 1, __ATOMIC_RELAXED) > mod) {
+        cmap_grow(cmap);
+    }
+}
+
+int cmap_push_if(struct cmap* cmap, const void* key, const void* value)
+{
+    size_t mod;
+    const size_t hash = cmap->func(key);
+    pthread_mutex_t* lock = cmap->locks + (hash & (cmap->stripes - 1));
+    struct cmapnode* node, **bucket;
+
+    pthread_mutex_lock(lock);
+    mod = cmap->table->mod;
+    if (cmap_find(cmap, cmap->table, key, hash)) {
+        pthread_mutex_unlock(lock);
+        return 1;
+    }
+
+    node = cmapnode_create(cmap, key, value, hash);
+    bucket = cmap_bucket(cmap->table, hash);
+    node->next = *bucket;
+    CMAP_STORE(bucket, node);
+    pthread_mutex_unlock(lock);
+
+    if (__atomic_add_fetch(&cmap->size, 1, __ATOMIC_RELAXED) > mod) {
+        cmap_grow(cmap);
+    }
+    return 0;
+}
+
+int cmap_remove(struct cmap* cmap, const void* key)
+{
+    const size_t hash = cmap->func(key);
+    pthread_mutex_t* lock = cmap->locks + (hash & (cmap->stripes - 1));
+    struct cmapnode* node, **ref;
+
+    pthread_mutex_lock(lock);
+    ref = cmap_bucket(cmap->table, hash);
+    for (node = *ref; node; ref = &node->next, node = node->next) {
+        if (node->hash == hash) {
+            const char* k = _cmapnode_key(node);
+            if (cmap->eq ? cmap->eq(k, key) : !memcmp(k, key, cmap->key_bytes)) {
+                CMAP_STORE(ref, node->next);
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(lock);
+
+    if (node) {
+        __atomic_sub_fetch(&cmap->size, 1, __ATOMIC_RELAXED);
+        cmap_retire(cmap, node);
+        return 1;
+    }
+
+    return 0;
+}
+
+void cmap_free(struct cmap* cmap)
+{
+    if (cmap->table) {
+        size_t i;
+        struct cmapnode* node, *next;
+        for (i = 0; i < cmap->table->mod; ++i) {
+            for (node = cmap->table->buckets[i]; node; node = next) {
+                next = node->next;
+                free(node);
+            }
+        }
+
+        for (i = 0; i < cmap->garbage_size; ++i) {
+            free(cmap->garbage[i]);
+        }
+
+        for (i = 0; i < cmap->stripes + 2; ++i) {
+            pthread_mutex_destroy(cmap->locks + i);
+        }
+
+        free(cmap->table);
+        free(cmap->garbage);
+        free(cmap->locks);
+        free(cmap->readers);
+
+        cmap->table = NULL;
+        cmap->locks = NULL;
+        cmap->readers = NULL;
+        cmap->garbage = NULL;
+        cmap->garbage_size = 0;
+        cmap->garbage_cap = 0;
+        cmap->size = 0;
+    }
+}
+
+#endif /* UTOPIA_CMAP_IMPLEMENTED */
+#endif /* UTOPIA_IMPLEMENTATION */
@@ -0,0 +1,254 @@
+
+/*  Copyright (c) 2022 Eugenio Arteaga A.
+
+Permission is hereby granted, free of charge, to any 
+person obtaining a copy of this software and associated 
+documentation files (the "Software"), to deal in the 
+Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to 
+permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice 
+shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+#ifndef UTOPIA_HASH_H
+#define UTOPIA_HASH_H
+
+/*=======================================================
+**************  UTOPIA UTILITY LIBRARY   ****************
+Simple and easy generic containers & data structures in C 
+================================== @Eugenio Arteaga A. */
+
+/*****************************
+Seeded Hash Function Library
+*****************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef USTDDEF_H
+#define USTDDEF_H <stddef.h>
+#endif
+
+#include USTDDEF_H
+
+size_t hash_bytes(const void* data, const size_t length, const size_t seed);
+size_t hash_fixed(const void* key, const size_t bytes, const size_t seed);
+size_t hash_string(const void* key, const size_t bytes, const size_t seed);
+size_t hash_uint(const void* key, const size_t bytes, const size_t seed);
+size_t hash_seed(void);
+int equal_string(const void* a, const void* b);
+
+/* hash_string hashes the string behind a char* key, pair it with equal_string
+through *_overload_eq: overloaded containers otherwise memcmp the pointers */
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* UTOPIA_HASH_H */
+
+#ifdef UTOPIA_IMPLEMENTATION
+
+#ifndef UTOPIA_HASH_IMPLEMENTED
+#define UTOPIA_HASH_IMPLEMENTED
+
+#ifndef USTRING_H 
+#define USTRING_H <string.h>
+#endif
+
+#include USTRING_H
+#include <limits.h>
+#include <time.h>
+
+#if ULONG_MAX > 0xFFFFFFFFUL
+
+#define HASH_P0 0x2D358DCCAA6C78A5UL
+#define HASH_P1 0x8BB84B93962EACC9UL
+#define HASH_P2 0x4B33A62ED433D4A3UL
+#define HASH_P3 0x4D5A2DA51DE1AA47UL
+
+static void hash_mum(unsigned long* a, unsigned long* b)
+{
+#ifdef __SIZEOF_INT128__
+    __extension__ typedef unsigned __int128 hash_u128;
+    hash_u128 r = (hash_u128)*a * *b;
+    *a = (unsigned long)r;
+    *b = (unsigned long)(r >> 64);
+#else
+    const unsigned long ha = *a >> 32, hb = *b >> 32;
+    const unsigned long la = *a & 0xFFFFFFFFUL, lb = *b & 0xFFFFFFFFUL;
+    const unsigned long rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    const unsigned long t = rl + (rm0 << 32), lo = t + (rm1 << 32);
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + (t < rl) + (lo < t);
+#endif
+}
+
+static unsigned long hash_mix(unsigned long a, unsigned long b)
+{
+    hash_mum(&a, &b);
+    return a ^ b;
+}
+
+static unsigned long hash_read8(const unsigned char* p)
+{
+    unsigned long v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+static unsigned long hash_read4(const unsigned char* p)
+{
+    unsigned int v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+size_t hash_bytes(const void* data, const size_t length, const size_t seed)
+{
+    size_t i = length;
+    unsigned long a, b, s = seed;
+    const unsigned char* p = data;
+
+    s ^= hash_mix(s ^ HASH_P0, HASH_P1);
+    if (length <= 16) {
+        if (length >= 4) {
+            a = (hash_read4(p) << 32) | hash_read4(p + ((length >> 3) << 2));
+            b = (hash_read4(p + length - 4) << 32) | hash_read4(p + length - 4 - ((length >> 3) << 2));
+        }
+        else if (length) {
+            a = ((unsigned long)p[0] << 16) | ((unsigned long)p[length >> 1] << 8) | p[length - 1];
+            b = 0;
+        }
+        else a = b = 0;
+    }
+    else {
+        if (i > 48) {
+            unsigned long s1 = s, s2 = s;
+            do {
+                s = hash_mix(hash_read8(p) ^ HASH_P1, hash_read8(p + 8) ^ s);
+                s1 = hash_mix(hash_read8(p + 16) ^ HASH_P2, hash_read8(p + 24) ^ s1);
+                s2 = hash_mix(hash_read8(p + 32) ^ HASH_P3, hash_read8(p + 40) ^ s2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            s ^= s1 ^ s2;
+        }
+
+        while (i > 16) {
+            s = hash_mix(hash_read8(p) ^ HASH_P1, hash_read8(p + 8) ^ s);
+            p += 16;
+            i -= 16;
+        }
+
+        a = hash_read8(p + i - 16);
+        b = hash_read8(p + i - 8);
+    }
+
+    a ^= HASH_P1;
+    b ^= s;
+    hash_mum(&a, &b);
+    return (size_t)hash_mix(a ^ HASH_P0 ^ length, b ^ HASH_P1);
+}
+
+size_t hash_uint(const void* key, const size_t bytes, const size_t seed)
+{
+    unsigned long x = 0;
+    if (bytes > sizeof(x)) {
+        return hash_bytes(key, bytes, seed);
+    }
+
+    memcpy(&x, key, bytes);
+    return (size_t)hash_mix(x ^ HASH_P0, (unsigned long)seed ^ HASH_P1);
+}
+
+#else /* 32-bit unsigned long */
+
+#define HASH_P0 0x9E3779B1UL
+#define HASH_P1 0x85EBCA77UL
+#define HASH_P2 0xC2B2AE3DUL
+
+static unsigned long hash_fmix(unsigned long h)
+{
+    h &= 0xFFFFFFFFUL;
+    h ^= h >> 16;
+    h = (h * HASH_P1) & 0xFFFFFFFFUL;
+    h ^= h >> 13;
+    h = (h * HASH_P2) & 0xFFFFFFFFUL;
+    return h ^ (h >> 16);
+}
+
+size_t hash_bytes(const void* data, const size_t length, const size_t seed)
+{
+    size_t i;
+    unsigned long h = ((unsigned long)seed ^ HASH_P0) + length, k;
+    const unsigned char* p = data;
+    for (i = 0; i + 4 <= length; i += 4) {
+        k = (unsigned long)p[i] | ((unsigned long)p[i + 1] << 8) | 
+            ((unsigned long)p[i + 2] << 16) | ((unsigned long)p[i + 3] << 24);
+        k = (k * 0xCC9E2D51UL) & 0xFFFFFFFFUL;
+        k = ((k << 15) | (k >> 17)) & 0xFFFFFFFFUL;
+        h ^= (k * 0x1B873593UL) & 0xFFFFFFFFUL;
+        h = ((h << 13) | ((h & 0xFFFFFFFFUL) >> 19)) & 0xFFFFFFFFUL;
+        h = (h * 5 + 0xE6546B64UL) & 0xFFFFFFFFUL;
+    }
+
+    for (k = 0; i < length; ++i) {
+        k = (k << 8) | p[i];
+    }
+    return (size_t)hash_fmix(h ^ hash_fmix(k + HASH_P0));
+}
+
+size_t hash_uint(const void* key, const size_t bytes, const size_t seed)
+{
+    unsigned long x = 0;
+    if (bytes > sizeof(x)) {
+        return hash_bytes(key, bytes, seed);
+    }
+
+    memcpy(&x, key, bytes);
+    return (size_t)hash_fmix(hash_fmix(x ^ (unsigned long)seed) + HASH_P0);
+}
+
+#endif /* ULONG_MAX */
+
+size_t hash_fixed(const void* key, const size_t bytes, const size_t seed)
+{
+    return hash_bytes(key, bytes, seed);
+}
+
+size_t hash_string(const void* key, const size_t bytes, const size_t seed)
+{
+    const char* str = *(const char**)key;
+    (void)bytes;
+    return hash_bytes(str, strlen(str), seed);
+}
+
+int equal_string(const void* a, const void* b)
+{
+    return !strcmp(*(const char**)a, *(const char**)b);
+}
+
+size_t hash_seed(void)
+{
+    static size_t counter;
+    size_t seed = (size_t)time(NULL) ^ (size_t)clock() ^ (size_t)&counter ^ (size_t)&seed;
+    seed ^= ++counter;
+    return hash_bytes(&seed, sizeof(seed), (size_t)HASH_P2);
+}
+
+#endif /* UTOPIA_HASH_IMPLEMENTED */
+#endif /* UTOPIA_IMPLEMENTATION */
@@ -0,0 +1,517 @@
+
+/*  Copyright (c) 2022 Eugenio Arteaga A.
+
+Permission is hereby granted, free of charge, to any 
+person obtaining a copy of this software and associated 
+documentation files (the "Software"), to deal in the 
+Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to 
+permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice 
+shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+#ifndef UTOPIA_HLL_H
+#define UTOPIA_HLL_H
+
+/*=======================================================
+**************  UTOPIA UTILITY LIBRARY   ****************
+Simple and easy generic containers & data structures in C 
+================================== @Eugenio Arteaga A. */
+
+/*****************************
+HyperLogLog Cardinality Sketch
+*****************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef USTDDEF_H
+#define USTDDEF_H <stddef.h>
+#endif
+
+#include USTDDEF_H
+
+struct hll {
+    unsigned char* registers;
+    unsigned int* sparse;
+    size_t count;
+    size_t capacity;
+    size_t precision;
+    size_t bytes;
+    size_t seed;
+    size_t (*func)(const void*);
+    size_t (*seeded)(const void*, size_t, size_t);
+};
+
+struct hll hll_create(const size_t bytes, const size_t precision);
+struct hll hll_copy(const struct hll* hll);
+void hll_overload(struct hll* hll, size_t (*func)(const void*));
+void hll_overload_seeded(struct hll* hll, size_t (*func)(const void*, size_t, size_t), size_t seed);
+void hll_push(struct hll* hll, const void* data);
+void hll_push_hash(struct hll* hll, const size_t hash);
+size_t hll_count(const struct hll* hll);
+size_t hll_bytes(const struct hll* hll);
+int hll_merge(struct hll* hll, const struct hll* other);
+size_t hll_serialize(const struct hll* hll, void* buffer);
+int hll_deserialize(struct hll* hll, const void* data, const size_t bytes);
+void hll_free(struct hll* hll);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* UTOPIA_HLL_H */
+
+#ifdef UTOPIA_IMPLEMENTATION
+
+#ifndef UTOPIA_HLL_IMPLEMENTED
+#define UTOPIA_HLL_IMPLEMENTED
+
+#ifndef USTDLIB_H 
+#define USTDLIB_H <stdlib.h>
+#endif
+
+#ifndef USTRING_H 
+#define USTRING_H <string.h>
+#endif
+
+#include USTDLIB_H
+#include USTRING_H
+#include <limits.h>
+
+/* Hashable Implementation */
+
+#ifndef UTOPIA_HASHABLE_IMPLEMENTED
+#define UTOPIA_HASHABLE_IMPLEMENTED
+
+#ifndef UTOPIA_HASH_SIZE
+#define UTOPIA_HASH_SIZE 32
+#endif
+
+static void* memdup(const void* src, size_t size)
+{
+    void* dup = malloc(size);
+    memcpy(dup, src, size);
+    return dup;
+}
+
+static size_t hash_default(const void* key)
+{
+#ifndef UTOPIA_HASH_UINT
+    int c;
+    size_t hash = 5381;
+    const unsigned char* str = *(unsigned char**)key;
+    while ((c = *str++)) {
+        hash = ((hash << 5) + hash) + c;
+    }
+    return hash;
+#else
+    size_t x = *(size_t*)key;
+    x = ((x >> 16) ^ x) * 0x45d9f3b;
+    x = ((x >> 16) ^ x) * 0x45d9f3b;
+    return (x >> 16) ^ x;
+#endif
+}
+
+#endif /* UTOPIA_HASHABLE_IMPLEMENTED */
+
+/*****************************
+HyperLogLog Cardinality Sketch
+*****************************/
+
+#ifndef UTOPIA_HLL_PRECISION
+#define UTOPIA_HLL_PRECISION 14
+#endif
+
+#if ULONG_MAX > 0xFFFFFFFFUL
+#define HLL_MIX_A 0xFF51AFD7ED558CCDUL
+#define HLL_MIX_B 0xC4CEB9FE1A85EC53UL
+#define HLL_SPARSE_PRECISION 25
+#else
+#define HLL_MIX_A 0x85EBCA6BUL
+#define HLL_MIX_B 0xC2B2AE35UL
+#define HLL_SPARSE_PRECISION 20
+#endif
+
+#define HLL_MIN_PRECISION 4
+#define HLL_MAX_PRECISION 18
+#define HLL_BITS (sizeof(size_t) * 8)
+#define HLL_RANK_BITS 6
+#define HLL_RANK_MASK 63
+#define HLL_LN2 0.69314718055994530942
+
+#define HLL_MAGIC "UHLL"
+#define HLL_VERSION 1
+#define HLL_HEADER 12
+#define HLL_DENSE 1
+
+#define HLL_HASH(hll, data) \
+    ((hll)->seeded ? (hll)->seeded((data), (hll)->bytes, (hll)->seed) : (hll)->func(data))
+#define HLL_REGISTERS(hll) ((size_t)1 << (hll)->precision)
+#define HLL_SPARSE_MAX(hll) (HLL_REGISTERS(hll) / sizeof(unsigned int))
+
+static size_t hll_mix(size_t x)
+{
+    x ^= x >> (HLL_BITS / 2);
+    x *= HLL_MIX_A;
+    x ^= x >> (HLL_BITS / 2);
+    x *= HLL_MIX_B;
+    return x ^ (x >> (HLL_BITS / 2));
+}
+
+static size_t hll_rank(size_t word, const size_t bits)
+{
+    size_t rank = 1;
+    while (rank <= bits && !(word >> (HLL_BITS - 1))) {
+        word <<= 1;
+        ++rank;
+    }
+    return rank;
+}
+
+static double hll_log(double x)
+{
+    size_t k;
+    double y, y2, sum = 0.0, log = 0.0;
+    while (x > 2.0) {
+        x *= 0.5;
+        log += HLL_LN2;
+    }
+    
+    while (x < 1.0) {
+        x *= 2.0;
+        log -= HLL_LN2;
+    }
+
+    y = (x - 1.0) / (x + 1.0);
+    y2 = y * y;
+    for (k = 1; k < 40; k += 2, y *= y2) {
+        sum += y / (double)k;
+    }
+    return log + 2.0 * sum;
+}
+
+static void hll_dense_push(unsigned char* registers, const size_t precision, const unsigned int entry)
+{
+    const size_t extra = HLL_SPARSE_PRECISION - precision;
+    const size_t index = entry >> HLL_RANK_BITS;
+    const size_t low = index & (((size_t)1 << extra) - 1);
+    const size_t rank = low ? hll_rank(low << (HLL_BITS - extra), extra) : extra + (entry & HLL_RANK_MASK);
+    unsigned char* reg = registers + (index >> extra);
+    if (rank > *reg) {
+        *reg = (unsigned char)rank;
+    }
+}
+
+static void hll_densify(struct hll* hll)
+{
+    size_t i;
+    hll->registers = calloc(HLL_REGISTERS(hll), 1);
+    for (i = 0; i < hll->count; ++i) {
+        hll_dense_push(hll->registers, hll->precision, hll->sparse[i]);
+    }
+
+    free(hll->sparse);
+    hll->sparse = NULL;
+    hll->count = 0;
+    hll->capacity = 0;
+}
+
+static void hll_sparse_push(struct hll* hll, const unsigned int entry)
+{
+    const unsigned int index = entry >> HLL_RANK_BITS;
+    size_t lo = 0, hi = hll->count;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if ((hll->sparse[mid] >> HLL_RANK_BITS) < index) {
+            lo = mid + 1;
+        }
+        else hi = mid;
+    }
+
+    if (lo < hll->count && (hll->sparse[lo] >> HLL_RANK_BITS) == index) {
+        if (hll->sparse[lo] < entry) {
+            hll->sparse[lo] = entry;
+        }
+        return;
+    }
+
+    if (hll->count == hll->capacity) {
+        hll->capacity = hll->capacity ? hll->capacity * 2 : 16;
+        hll->sparse = realloc(hll->sparse, hll->capacity * sizeof(unsigned int));
+    }
+
+    memmove(hll->sparse + lo + 1, hll->sparse + lo, (hll->count - lo) * sizeof(unsigned int));
+    hll->sparse[lo] = entry;
+    if (++hll->count > HLL_SPARSE_MAX(hll)) {
+        hll_densify(hll);
+    }
+}
+
+static void hll_sparse_merge(struct hll* hll, const unsigned int* entries, const size_t count)
+{
+    size_t i = 0, j = 0, n = 0;
+    unsigned int* sparse = malloc((hll->count + count + 1) * sizeof(unsigned int));
+    while (i < hll->count || j < count) {
+        if (j == count || (i < hll->count && (hll->sparse[i] >> HLL_RANK_BITS) < (entries[j] >> HLL_RANK_BITS))) {
+            sparse[n++] = hll->sparse[i++];
+        }
+        else if (i == hll->count || (entries[j] >> HLL_RANK_BITS) < (hll->sparse[i] >> HLL_RANK_BITS)) {
+            sparse[n++] = entries[j++];
+        }
+        else {
+            sparse[n++] = hll->sparse[i] > entries[j] ? hll->sparse[i] : entries[j];
+            ++i;
+            ++j;
+        }
+    }
+
+    free(hll->sparse);
+    hll->sparse = sparse;
+    hll->count = n;
+    hll->capacity = hll->count + count + 1;
+    if (hll->count > HLL_SPARSE_MAX(hll)) {
+        hll_densify(hll);
+    }
+}
+
+static void hll_write32(unsigned char* out, const size_t value)
+{
+    out[0] = (unsigned char)(value & 0xFF);
+    out[1] = (unsigned char)((value >> 8) & 0xFF);
+    out[2] = (unsigned char)((value >> 16) & 0xFF);
+    out[3] = (unsigned char)((value >> 24) & 0xFF);
+}
+
+static size_t hll_read32(const unsigned char* in)
+{
+    return (size_t)in[0] | ((size_t)in[1] << 8) | ((size_t)in[2] << 16) | ((size_t)in[3] << 24);
+}
+
+struct hll hll_create(const size_t bytes, const size_t precision)
+{
+    struct hll hll;
+    hll.registers = NULL;
+    hll.sparse = NULL;
+    hll.count = 0;
+    hll.capacity = 0;
+    hll.precision = precision ? precision : UTOPIA_HLL_PRECISION;
+    hll.precision = hll.precision < HLL_MIN_PRECISION ? HLL_MIN_PRECISION : hll.precision;
+    hll.precision = hll.precision > HLL_MAX_PRECISION ? HLL_MAX_PRECISION : hll.precision;
+    hll.bytes = bytes + !bytes;
+    hll.seed = 0;
+    hll.func = &hash_default;
+    hll.seeded = NULL;
+    return hll;
+}
+
+struct hll hll_copy(const struct hll* hll)
+{
+    struct hll h = *hll;
+    if (hll->registers) {
+        h.registers = memdup(hll->registers, HLL_REGISTERS(hll));
+    }
+    else if (hll->sparse) {
+        h.sparse = memdup(hll->sparse, hll->capacity * sizeof(unsigned int));
+    }
+    return h;
+}
+
+void hll_overload(struct hll* hll, size_t (*func)(const void*))
+{
+    hll->func = func;
+    hll->seeded = NULL;
+}
+
+void hll_overload_seeded(struct hll* hll, size_t (*func)(const void*, size_t, size_t), size_t seed)
+{
+    hll->seeded = func;
+    hll->seed = seed;
+}
+
+void hll_push_hash(struct hll* hll, const size_t hash)
+{
+    const size_t word = hll_mix(hash);
+    if (hll->registers) {
+        const size_t rank = hll_rank(word << hll->precision, HLL_BITS - hll->precision);
+        unsigned char* reg = hll->registers + (word >> (HLL_BITS - hll->precision));
+        if (rank > *reg) {
+            *reg = (unsigned char)rank;
+        }
+    }
+    else {
+        const size_t rank = hll_rank(word << HLL_SPARSE_PRECISION, HLL_BITS - HLL_SPARSE_PRECISION);
+        const size_t index = word >> (HLL_BITS - HLL_SPARSE_PRECISION);
+        hll_sparse_push(hll, (unsigned int)((index << HLL_RANK_BITS) | rank));
+    }
+}
+
+void hll_push(struct hll* hll, const void* data)
+{
+    hll_push_hash(hll, HLL_HASH(hll, data));
+}
+
+size_t hll_count(const struct hll* hll)
+{
+    size_t i, zeros = 0;
+    double m, alpha, estimate, sum = 0.0, scale[65];
+    if (!hll->registers) {
+        m = (double)((size_t)1 << HLL_SPARSE_PRECISION);
+        return (size_t)(m * hll_log(m / (m - (double)hll->count)) + 0.5);
+    }
+
+    for (scale[0] = 1.0, i = 1; i < 65; ++i) {
+        scale[i] = scale[i - 1] * 0.5;
+    }
+
+    m = (double)HLL_REGISTERS(hll);
+    for (i = 0; i < HLL_REGISTERS(hll); ++i) {
+        sum += scale[hll->registers[i]];
+        zeros += !hll->registers[i];
+    }
+
+    alpha = hll->precision == 4 ? 0.673 : hll->precision == 5 ? 0.697 : 
+            hll->precision == 6 ? 0.709 : 0.7213 / (1.0 + 1.079 / m);
+    estimate = alpha * m * m / sum;
+    if (zeros && estimate <= 2.5 * m) {
+        estimate = m * hll_log(m / (double)zeros);
+    }
+    return (size_t)(estimate + 0.5);
+}
+
+size_t hll_bytes(const struct hll* hll)
+{
+    return hll->registers ? HLL_REGISTERS(hll) : hll->capacity * sizeof(unsigned int);
+}
+
+int hll_merge(struct hll* hll, const struct hll* other)
+{
+    size_t i;
+    if (hll->precision != other->precision) {
+        return 0;
+    }
+
+    if (other->registers) {
+        if (!hll->registers) {
+            hll_densify(hll);
+        }
+
+        for (i = 0; i < HLL_REGISTERS(hll); ++i) {
+            hll->registers[i] = hll->registers[i] > other->registers[i] ? 
+                                hll->registers[i] : other->registers[i];
+        }
+    }
+    else if (hll->registers) {
+        for (i = 0; i < other->count; ++i) {
+            hll_dense_push(hll->registers, hll->precision, other->sparse[i]);
+        }
+    }
+    else if (other->count) {
+        hll_sparse_merge(hll, other->sparse, other->count);
+    }
+    return 1;
+}
+
+size_t hll_serialize(const struct hll* hll, void* buffer)
+{
+    size_t i;
+    unsigned char* out = buffer;
+    const size_t bytes = HLL_HEADER + (hll->registers ? HLL_REGISTERS(hll) : hll->count * 4);
+    if (!out) {
+        return bytes;
+    }
+
+    memcpy(out, HLL_MAGIC, 4);
+    out[4] = HLL_VERSION;
+    out[5] = (unsigned char)hll->precision;
+    out[6] = (unsigned char)(hll->registers ? HLL_DENSE : 0);
+    out[7] = HLL_SPARSE_PRECISION;
+    hll_write32(out + 8, hll->count);
+    if (hll->registers) {
+        memcpy(out + HLL_HEADER, hll->registers, HLL_REGISTERS(hll));
+    }
+    else {
+        for (i = 0; i < hll->count; ++i) {
+            hll_write32(out + HLL_HEADER + i * 4, hll->sparse[i]);
+        }
+    }
+    return bytes;
+}
+
+int hll_deserialize(struct hll* hll, const void* data, const size_t bytes)
+{
+    size_t i, count;
+    struct hll h = *hll;
+    const unsigned char* in = data;
+    if (bytes < HLL_HEADER || memcmp(in, HLL_MAGIC, 4) || in[4] != HLL_VERSION || 
+        in[5] < HLL_MIN_PRECISION || in[5] > HLL_MAX_PRECISION) {
+        return 0;
+    }
+
+    h.precision = in[5];
+    h.registers = NULL;
+    h.sparse = NULL;
+    h.count = h.capacity = 0;
+    count = hll_read32(in + 8);
+    if (in[6] == HLL_DENSE) {
+        if (bytes != HLL_HEADER + HLL_REGISTERS(&h)) {
+            return 0;
+        }
+
+        for (i = 0; i < HLL_REGISTERS(&h); ++i) {
+            if (in[HLL_HEADER + i] > HLL_BITS - h.precision + 1) {
+                return 0;
+            }
+        }
+        h.registers = memdup(in + HLL_HEADER, HLL_REGISTERS(&h));
+    }
+    else {
+        if (in[7] != HLL_SPARSE_PRECISION || count > HLL_SPARSE_MAX(&h) || bytes != HLL_HEADER + count * 4) {
+            return 0;
+        }
+
+        h.sparse = malloc((count + 1) * sizeof(unsigned int));
+        for (i = 0; i < count; ++i) {
+            h.sparse[i] = (unsigned int)hll_read32(in + HLL_HEADER + i * 4);
+            if ((h.sparse[i] >> HLL_RANK_BITS) >= ((size_t)1 << HLL_SPARSE_PRECISION) || 
+                !(h.sparse[i] & HLL_RANK_MASK) ||
+                (h.sparse[i] & HLL_RANK_MASK) > HLL_BITS - HLL_SPARSE_PRECISION + 1 ||
+                (i && (h.sparse[i] >> HLL_RANK_BITS) <= (h.sparse[i - 1] >> HLL_RANK_BITS))) {
+                free(h.sparse);
+                return 0;
+            }
+        }
+        h.count = count;
+        h.capacity = count + 1;
+    }
+
+    hll_free(hll);
+    *hll = h;
+    return 1;
+}
+
+void hll_free(struct hll* hll)
+{
+    free(hll->registers);
+    free(hll->sparse);
+    hll->registers = NULL;
+    hll->sparse = NULL;
+    hll->count = 0;
+    hll->capacity = 0;
+}
+
+#endif /* UTOPIA_HLL_IMPLEMENTED */
+#endif /* UTOPIA_IMPLEMENTATION */
@@ -45,15 +45,67 @@ extern "C" {
 
 #include USTDDEF_H
 
+struct mapmode {
+    size_t** rehash;
+    unsigned int* links;
+    unsigned char* pilots;
+    size_t* filter;
+    size_t* packed;
+    void* image;
+    char* arena;
+    size_t rehash_mod;
+    size_t rehash_index;
+    size_t rehash_step;
+    size_t pilot_mod;
+    size_t pilot_seed;
+    size_t image_bytes;
+    size_t arena_size;
+    size_t arena_cap;
+    size_t resizes;
+    size_t probes;
+    size_t hash_calls;
+};
+
 struct map {
     size_t** indices;
+    size_t* hashes;
     void* keys;
     void* values;
+    size_t* shared;
+    struct mapmode* mode;
     size_t key_bytes;
     size_t value_bytes;
     size_t size;
     size_t mod;
+    int compact;
+    size_t seed;
     size_t (*func)(const void*);
+    size_t (*seeded)(const void*, size_t, size_t);
+    int (*eq)(const void*, const void*);
+};
+
+struct mapslice {
+    size_t offset;
+    size_t length;
+};
+
+#ifndef UTOPIA_STATS_BINS
+#define UTOPIA_STATS_BINS 8
+#endif
+
+struct map_stats {
+    size_t size;
+    size_t capacity;
+    size_t rehash_pending;
+    size_t resizes;
+    size_t bytes;
+    size_t longest_chain;
+    size_t histogram[UTOPIA_STATS_BINS];
+    double load_factor;
+    double hit_probes;
+    double miss_probes;
+    size_t probes;
+    size_t hash_calls;
 };
 
 #define _map_key_at(map, i) ((char*)(map)->keys + (map)->key_bytes * (i))
@@ -61,19 +113,57 @@ struct map {
 
 struct map map_create(const size_t key_size, const size_t value_size);
 struct map map_reserve(const size_t key_size, const size_t value_size, const size_t reserve);
+struct map map_create_arena(void);
+struct map map_create_compact(const size_t key_size, const size_t value_size);
+struct map map_from_arrays(const size_t key_size, const size_t value_size, const void* keys, 
+                           const void* values, const size_t count, const size_t nthreads);
 struct map map_copy(const struct map* map);
+/* map_snapshot is O(1) and shares the whole table, the first write through
+either side copies it once (copy-on-write per table, not per chunk) */
+struct map map_snapshot(struct map* map);
+struct map map_open_mmap(const char* path);
+int map_save(const struct map* map, const char* path);
 size_t map_search(const struct map* map, const void* key);
+void map_search_batch(const struct map* map, const void* keys, const size_t count, size_t* indices);
+/* overloading the hash replaces the default strcmp equality with a memcmp of
+the key bytes, set map_overload_eq (e.g. equal_string) for char* keys */
 void map_overload(struct map* map, size_t (*hash_func)(const void*));
+void map_overload_eq(struct map* map, int (*eq_func)(const void*, const void*));
+void map_overload_seeded(struct map* map, size_t (*hash_func)(const void*, size_t, size_t), size_t seed);
+void map_filter(struct map* map, const double rate);
+/* map_key_at and map_value_at alias storage shared with snapshots and read-only
+mmap images, write values through map_value_mut which detaches the map first */
 void* map_key_at(const struct map* map, const size_t index);
 void* map_value_at(const struct map* map, const size_t index);
+void* map_value_mut(struct map* map, const size_t index);
 size_t map_size(const struct map* map);
 size_t map_capacity(const struct map* map);
 size_t map_key_bytes(const struct map* map);
 size_t map_value_bytes(const struct map* map);
+struct map_stats map_stats(const struct map* map);
+void map_incremental(struct map* map, const size_t step);
+/* map_freeze may reseed an overload_seeded hash when stored hashes collide */
+int map_freeze(struct map* map);
+void map_thaw(struct map* map);
 void map_resize(struct map* map, const size_t size);
 void* map_push(struct map* map, const void* key, const void* value);
 size_t map_push_if(struct map* map, const void* key, const void* value);
+void map_push_batch(struct map* map, const void* keys, const void* values,
+                    const size_t count, size_t* indices);
+void map_push_arrays(struct map* map, const void* keys, const void* values, 
+                     const size_t count, const size_t nthreads);
+void* map_upsert(struct map* map, const void* key, const void* value,
+                 void (*combine)(void*, const void*, void*), void* ctx);
+void map_upsert_batch(struct map* map, const void* keys, const void* values, const size_t count,
+                      void (*combine)(void*, const void*, void*), void* ctx);
 int map_remove(struct map* map, const void* key);
+int map_remove_swap(struct map* map, const void* key);
+void* map_arena_push(struct map* map, const void* key, const size_t key_len,
+                     const void* value, const size_t value_len);
+size_t map_arena_search(const struct map* map, const void* key, const size_t key_len);
+int map_arena_remove(struct map* map, const void* key, const size_t key_len);
+void* map_arena_key(const struct map* map, const size_t index, size_t* length);
+void* map_arena_value(const struct map* map, const size_t index, size_t* length);
 void map_free(struct map* map);
 
 #ifdef __cplusplus
@@ -94,8 +184,85 @@ void map_free(struct map* map);
 #define USTRING_H <string.h>
 #endif
 
+#ifndef USTDIO_H
+#define USTDIO_H <stdio.h>
+#endif
+
 #include USTDLIB_H
 #include USTRING_H
+#include USTDIO_H
+
+#if defined(__unix__) || defined(__APPLE__)
+#define UTOPIA_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(UTOPIA_NO_THREADS)
+#define UTOPIA_MAP_THREADS
+#include <pthread.h>
+#endif
+
+#if defined(__SSE2__) && !defined(UTOPIA_NO_SIMD)
+#define UTOPIA_MAP_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifndef UTOPIA_PREFETCH
+#ifdef __GNUC__
+#define UTOPIA_PREFETCH(ptr) __builtin_prefetch(ptr)
+#else
+#define UTOPIA_PREFETCH(ptr) (void)(ptr)
+#endif
+#endif
+
+#ifdef __GNUC__
+#define MAP_SHARED_ACQUIRE(shared) __atomic_add_fetch(shared, 1, __ATOMIC_ACQ_REL)
+#define MAP_SHARED_RELEASE(shared) __atomic_sub_fetch(shared, 1, __ATOMIC_ACQ_REL)
+#define MAP_SHARED_LOAD(shared) __atomic_load_n(shared, __ATOMIC_ACQUIRE)
+#else
+#define MAP_SHARED_ACQUIRE(shared) (++*(shared))
+#define MAP_SHARED_RELEASE(shared) (--*(shared))
+#define MAP_SHARED_LOAD(shared) (*(shared))
+#endif
+
+#define MAP_HASH(map, key) \
+    ((map)->seeded ? (map)->seeded((key), (map)->key_bytes, (map)->seed) : (map)->func(key))
+
+#define MAP_MODE(map, field) ((map)->mode ? (map)->mode->field : 0)
+
+#ifdef UTOPIA_STATS
+#define MAP_STATS_COUNT(map, field) ((map)->mode ? (void)++(map)->mode->field : (void)0)
+#define MAP_STATS_MODE(map) ((void)map_mode(map))
+#else
+#define MAP_STATS_COUNT(map, field) ((void)0)
+#define MAP_STATS_MODE(map) ((void)0)
+#endif
+
+#ifndef UTOPIA_MAP_BATCH
+#define UTOPIA_MAP_BATCH 16
+#endif
+
+#ifndef UTOPIA_MAP_SMALL
+#define UTOPIA_MAP_SMALL 16
+#endif
+
+#if UTOPIA_MAP_SMALL > 32
+#error "UTOPIA_MAP_SMALL must not exceed 32"
+#endif
+
+#define MAP_SMALL(map) ((map)->mod && !(map)->indices && \
+    (!(map)->mode || (!(map)->mode->links && !(map)->mode->pilots && !(map)->mode->packed)))
+
+static struct mapmode* map_mode(struct map* map)
+{
+    if (!map->mode) {
+        map->mode = calloc(1, sizeof(struct mapmode));
+    }
+    return map->mode;
+}
 
 /* Bucket Implementation */
 
@@ -208,216 +375,2197 @@ static size_t hash_default(const void* key)
 
 #endif /* UTOPIA_HASHABLE_IMPLEMENTED */
 
-/****************************
-Generic <Key, Value> Hash Map
-*****************************/
+/* Equality Implementation */
 
-struct map map_create(const size_t key_size, const size_t value_size)
+#ifndef UTOPIA_EQUALS_IMPLEMENTED
+#define UTOPIA_EQUALS_IMPLEMENTED
+
+static int equal_default(const void* a, const void* b)
 {
-    struct map map;
-    map.indices = NULL;
-    map.keys = NULL;
-    map.values = NULL;
-    map.key_bytes = key_size + !key_size;
-    map.value_bytes = value_size + !value_size;
-    map.size = 0;
-    map.mod = 0;
-    map.func = &hash_default;
-    return map;
+#ifndef UTOPIA_HASH_UINT
+    return !strcmp(*(char**)a, *(char**)b);
+#else
+    return *(size_t*)a == *(size_t*)b;
+#endif
 }
 
-struct map map_reserve(const size_t key_size, const size_t value_size, const size_t reserve)
+#endif /* UTOPIA_EQUALS_IMPLEMENTED */
+
+/* Filter Implementation */
+
+#ifndef UTOPIA_FILTER_IMPLEMENTED
+#define UTOPIA_FILTER_IMPLEMENTED
+
+#define FILTER_BLOOM 1
+#define FILTER_FUSE 2
+
+#define FILTER_KIND_INDEX 0
+#define FILTER_COUNT_INDEX 1
+#define FILTER_SEED_INDEX 2
+#define FILTER_BITS_INDEX 3
+#define FILTER_HEADER 4
+
+#define FILTER_BLOCK_BYTES 64
+#define FILTER_BLOCK_BITS 512
+#define FILTER_GOLDEN 0x9E3779B9
+
+#define FILTER_DATA(filter) ((unsigned char*)(((size_t)((filter) + FILTER_HEADER) + \
+                             FILTER_BLOCK_BYTES - 1) & ~(size_t)(FILTER_BLOCK_BYTES - 1)))
+#define FILTER_DATA_BYTES(filter) ((filter)[FILTER_KIND_INDEX] == FILTER_BLOOM ? \
+                                   (filter)[FILTER_COUNT_INDEX] * FILTER_BLOCK_BYTES : \
+                                   (filter)[FILTER_COUNT_INDEX] * 3)
+#define FILTER_BYTES(filter) (FILTER_HEADER * sizeof(size_t) + FILTER_BLOCK_BYTES + FILTER_DATA_BYTES(filter))
+
+#define FILTER_BLOOM_BLOCK(filter, hash) \
+    (FILTER_DATA(filter) + filter_mix(hash) % (filter)[FILTER_COUNT_INDEX] * FILTER_BLOCK_BYTES)
+#define FILTER_BLOOM_BIT(pos) (1 << ((pos) & 7))
+#define FILTER_BLOOM_BYTE(pos) (((pos) % FILTER_BLOCK_BITS) >> 3)
+
+#define FILTER_FUSE_SLOT(mix, i, count) ((i) * (count) + filter_mix((mix) + (size_t)(i) * FILTER_GOLDEN) % (count))
+#define FILTER_FUSE_PRINT(mix) ((unsigned char)((mix) >> 8))
+
+static size_t filter_mix(size_t x)
 {
-    struct map map;
-    map.key_bytes = key_size + !key_size;
-    map.value_bytes = value_size + !value_size;
-    map.indices = reserve ? calloc(reserve, sizeof(size_t*)) : NULL;
-    map.keys = reserve ? malloc(reserve * map.key_bytes) : NULL;
-    map.values = reserve ? malloc(reserve * map.value_bytes) : NULL;
-    map.mod = reserve;
-    map.size = 0;
-    map.func = &hash_default;
-    return map;
+    x ^= x >> (sizeof(size_t) * 4);
+    x = ((x >> 16) ^ x) * 0x45d9f3b;
+    x = ((x >> 16) ^ x) * 0x45d9f3b;
+    return (x >> 16) ^ x;
 }
 
-struct map map_copy(const struct map* map)
+static size_t filter_bits(const double rate)
 {
-    struct map m = *map;
-    if (map->mod) {
-        size_t i, size;
-
-        m.keys = memdup(map->keys, map->mod * map->key_bytes);
-        m.values = memdup(map->values, map->mod * map->value_bytes);
-        m.indices = memdup(map->indices, map->mod * sizeof(size_t*));
-        
-        for (i = 0; i < map->mod; ++i) {
-            size = BUCKET_SIZE(map->indices[i]);
-            if (size) {
-                size += BUCKET_DATA_INDEX;
-                m.indices[i] = memdup(map->indices[i], size * sizeof(size_t));
-            }
-        }
+    size_t bits = 0;
+    double p = 1.0;
+    while (p > rate && bits < 32) {
+        p *= 0.5;
+        ++bits;
     }
-    return m;
+    return (bits * 3 + 1) / 2;
 }
 
-size_t map_capacity(const struct map* map)
+static size_t* filter_alloc(const size_t kind, const size_t count, const size_t seed, const size_t bits)
 {
-    return map->mod;
+    size_t* filter, header[FILTER_HEADER];
+    header[FILTER_KIND_INDEX] = kind;
+    header[FILTER_COUNT_INDEX] = count;
+    header[FILTER_SEED_INDEX] = seed;
+    header[FILTER_BITS_INDEX] = bits;
+    filter = calloc(FILTER_BYTES(header), 1);
+    memcpy(filter, header, sizeof(header));
+    return filter;
 }
 
-void map_overload(struct map* map, size_t (*func)(const void*))
+static size_t* filter_copy(const size_t* filter)
 {
-    map->func = func;
+    size_t* copy = filter_alloc(filter[FILTER_KIND_INDEX], filter[FILTER_COUNT_INDEX],
+                                filter[FILTER_SEED_INDEX], filter[FILTER_BITS_INDEX]);
+    memcpy(FILTER_DATA(copy), FILTER_DATA(filter), FILTER_DATA_BYTES(filter));
+    return copy;
 }
 
-void* map_key_at(const struct map* map, const size_t index)
+static size_t* filter_bloom(size_t* filter, const size_t capacity, const size_t bits)
 {
-    return _map_key_at(map, index);
+    size_t k = (bits * 7 + 5) / 10;
+    k = k < 1 ? 1 : k > 16 ? 16 : k;
+    free(filter);
+    return filter_alloc(FILTER_BLOOM, (capacity * bits + FILTER_BLOCK_BITS - 1) / FILTER_BLOCK_BITS + 1, k, bits);
 }
 
-void* map_value_at(const struct map* map, const size_t index)
+static void filter_add(size_t* filter, const size_t hash)
 {
-    return _map_value_at(map, index);
+    size_t i, pos = filter_mix(hash ^ FILTER_GOLDEN);
+    const size_t step = (pos >> 16) | 1;
+    unsigned char* block = FILTER_BLOOM_BLOCK(filter, hash);
+    for (i = 0; i < filter[FILTER_SEED_INDEX]; ++i, pos += step) {
+        block[FILTER_BLOOM_BYTE(pos)] |= (unsigned char)FILTER_BLOOM_BIT(pos);
+    }
 }
 
-size_t map_size(const struct map* map)
+static int filter_query(const size_t* filter, const size_t hash)
 {
-    return map->size;
+    size_t i, pos, step;
+    const unsigned char* data;
+    if (filter[FILTER_KIND_INDEX] == FILTER_FUSE) {
+        const size_t count = filter[FILTER_COUNT_INDEX];
+        const size_t mix = filter_mix(hash ^ filter[FILTER_SEED_INDEX]);
+        data = FILTER_DATA(filter);
+        return FILTER_FUSE_PRINT(mix) == (data[FILTER_FUSE_SLOT(mix, 0, count)] ^
+                                          data[FILTER_FUSE_SLOT(mix, 1, count)] ^ 
+                                          data[FILTER_FUSE_SLOT(mix, 2, count)]);
+    }
+
+    pos = filter_mix(hash ^ FILTER_GOLDEN);
+    step = (pos >> 16) | 1;
+    data = FILTER_BLOOM_BLOCK(filter, hash);
+    for (i = 0; i < filter[FILTER_SEED_INDEX]; ++i, pos += step) {
+        if (!(data[FILTER_BLOOM_BYTE(pos)] & FILTER_BLOOM_BIT(pos))) {
+            return 0;
+        }
+    }
+    return 1;
 }
 
-size_t map_key_bytes(const struct map* map)
+#endif /* UTOPIA_FILTER_IMPLEMENTED */
+
+/****************************
+Generic <Key, Value> Hash Map
+*****************************/
+
+static int map_key_equal(const struct map* map, const void* a, const void* b)
 {
-    return map->key_bytes;
+    return map->eq ? map->eq(a, b) : !memcmp(a, b, map->key_bytes);
 }
 
-size_t map_value_bytes(const struct map* map)
+static size_t** map_buckets_copy(size_t** buckets, const size_t size)
 {
-    return map->value_bytes;
+    size_t i, count;
+    size_t** copy = memdup(buckets, size * sizeof(size_t*));
+    for (i = 0; i < size; ++i) {
+        count = BUCKET_SIZE(buckets[i]);
+        if (count) {
+            copy[i] = memdup(buckets[i], (count + BUCKET_DATA_INDEX) * sizeof(size_t));
+            copy[i][BUCKET_CAP_INDEX] = count;
+        }
+    }
+    return copy;
 }
 
-size_t map_search(const struct map* map, const void* data)
+/* Filter Build Implementation */
+
+#ifndef UTOPIA_MAP_FILTER_FUSE_BITS
+#define UTOPIA_MAP_FILTER_FUSE_BITS 12
+#endif
+
+#define MAP_FILTER_TRIES 16
+
+static int map_filter_compare(const void* a, const void* b)
 {
-    if (map->mod) {
-    
-        size_t i;
-        const size_t hash = map->func(data);
-        size_t* bucket = map->indices[hash % map->mod];
-    
-        const size_t size = BUCKET_SIZE(bucket) + BUCKET_DATA_INDEX;
-        for (i = BUCKET_DATA_INDEX; i < size; ++i) {
-            void* k = _map_key_at(map, bucket[i]);
-            if (hash == map->func(k)) {
-                return bucket[i] + 1;
+    const size_t x = *(const size_t*)a, y = *(const size_t*)b;
+    return (x > y) - (x < y);
+}
+
+static size_t* map_filter_fuse(const struct map* map)
+{
+    size_t i, j, n, s, t, mix, seed, head, top, attempt;
+    size_t* filter = NULL;
+    size_t* keys = malloc((map->size + 1) * sizeof(size_t));
+    size_t segment, cells, *counts, *masks, *queue, *order;
+    unsigned char* data;
+
+    memcpy(keys, map->hashes, map->size * sizeof(size_t));
+    qsort(keys, map->size, sizeof(size_t), &map_filter_compare);
+    for (n = 0, i = 0; i < map->size; ++i) {
+        if (!n || keys[i] != keys[n - 1]) {
+            keys[n++] = keys[i];
+        }
+    }
+
+    segment = (n + n / 4 + 32) / 3 + 1;
+    cells = 3 * segment;
+    counts = malloc(cells * sizeof(size_t));
+    masks = malloc(cells * sizeof(size_t));
+    queue = malloc(cells * sizeof(size_t));
+    order = malloc(2 * (n + 1) * sizeof(size_t));
+
+    for (attempt = 0; attempt < MAP_FILTER_TRIES && !filter; ++attempt) {
+        seed = filter_mix(attempt * FILTER_GOLDEN + 1);
+        memset(counts, 0, cells * sizeof(size_t));
+        memset(masks, 0, cells * sizeof(size_t));
+        for (i = 0; i < n; ++i) {
+            mix = filter_mix(keys[i] ^ seed);
+            for (j = 0; j < 3; ++j) {
+                s = FILTER_FUSE_SLOT(mix, j, segment);
+                ++counts[s];
+                masks[s] ^= mix;
+            }
+        }
+
+        for (head = 0, s = 0; s < cells; ++s) {
+            if (counts[s] == 1) {
+                queue[head++] = s;
+            }
+        }
+
+        for (top = 0; head;) {
+            s = queue[--head];
+            if (counts[s] != 1) {
+                continue;
+            }
+
+            mix = masks[s];
+            order[2 * top] = mix;
+            order[2 * top + 1] = s;
+            ++top;
+            for (j = 0; j < 3; ++j) {
+                t = FILTER_FUSE_SLOT(mix, j, segment);
+                masks[t] ^= mix;
+                if (--counts[t] == 1) {
+                    queue[head++] = t;
+                }
+            }
+        }
+
+        if (top == n) {
+            filter = filter_alloc(FILTER_FUSE, segment, seed, map->mode->filter[FILTER_BITS_INDEX]);
+            data = FILTER_DATA(filter);
+            while (top--) {
+                mix = order[2 * top];
+                data[order[2 * top + 1]] = FILTER_FUSE_PRINT(mix) ^ 
+                                           data[FILTER_FUSE_SLOT(mix, 0, segment)] ^
+                                           data[FILTER_FUSE_SLOT(mix, 1, segment)] ^ 
+                                           data[FILTER_FUSE_SLOT(mix, 2, segment)];
             }
         }
     }
-    
-    return 0;
+
+    free(order);
+    free(queue);
+    free(masks);
+    free(counts);
+    free(keys);
+    return filter;
 }
 
-void map_resize(struct map* map, const size_t new_size)
+static void map_filter_build(struct map* map)
 {
     size_t i;
-    const char* key;
-    const size_t size = map->size;
-    const size_t bytes = map->key_bytes;
+    const size_t bits = map->mode->filter[FILTER_BITS_INDEX];
+    if (map->mode->pilots && bits <= UTOPIA_MAP_FILTER_FUSE_BITS) {
+        size_t* fuse = map_filter_fuse(map);
+        if (fuse) {
+            free(map->mode->filter);
+            map->mode->filter = fuse;
+            return;
+        }
+    }
 
-    if (map->mod) {
-        buckets_free(map->indices, map->mod);
+    map->mode->filter = filter_bloom(map->mode->filter, map->mod, bits);
+    for (i = 0; i < map->size; ++i) {
+        filter_add(map->mode->filter, map->hashes[i]);
     }
+}
 
-    map->mod = new_size + !new_size * UTOPIA_HASH_SIZE;
-    map->keys = realloc(map->keys, map->mod * map->key_bytes);
-    map->values = realloc(map->values, map->mod * map->value_bytes);
-    map->indices = realloc(map->indices, map->mod * sizeof(size_t*));
-    memset(map->indices, 0, map->mod * sizeof(size_t*));
-    
-    key = map->keys;
-    for (i = 0; i < size; ++i, key += bytes) {
-        const size_t hash_mod = map->func(key) % map->mod;
-        map->indices[hash_mod] = bucket_push(map->indices[hash_mod], i);
+static size_t** map_bucket(const struct map* map, const size_t hash)
+{
+    if (MAP_MODE(map, rehash) && map->mode->rehash[hash % map->mode->rehash_mod]) {
+        return map->mode->rehash + hash % map->mode->rehash_mod;
     }
+    return map->indices + hash % map->mod;
 }
 
-int map_remove(struct map* map, const void* key)
+static void map_rehash_bucket(struct map* map, const size_t index)
 {
-    if (map->mod) {
+    size_t i;
+    size_t* bucket = map->mode->rehash[index];
+    const size_t size = BUCKET_SIZE(bucket) + BUCKET_DATA_INDEX;
+    for (i = BUCKET_DATA_INDEX; i < size; ++i) {
+        const size_t hashmod = map->hashes[bucket[i]] % map->mod;
+        map->indices[hashmod] = bucket_push(map->indices[hashmod], bucket[i]);
+    }
 
-        size_t i, search = 0;
-        const size_t hash = map->func(key);
-        size_t* bucket = map->indices[hash % map->mod];      
+    free(bucket);
+    map->mode->rehash[index] = NULL;
+}
 
-        const size_t size = BUCKET_SIZE(bucket) + BUCKET_DATA_INDEX;
-        for (i = BUCKET_DATA_INDEX; i < size; ++i) {
-            void* k = _map_key_at(map, bucket[i]);
-            if (hash == map->func(k)) {
-                search = i;
-                break;
-            }
+static void map_rehash(struct map* map, const size_t count)
+{
+    size_t end = map->mode->rehash_index + count;
+    end = end < map->mode->rehash_mod ? end : map->mode->rehash_mod;
+    for (; map->mode->rehash_index < end; ++map->mode->rehash_index) {
+        if (map->mode->rehash[map->mode->rehash_index]) {
+            map_rehash_bucket(map, map->mode->rehash_index);
         }
-        
-        if (search) {
-            const size_t find = bucket[search];
-            
-            char* key = _map_key_at(map, find);
-            char* val = _map_value_at(map, find);
-            memmove(key, key + map->key_bytes, (map->size - find - 1) * map->key_bytes);
-            memmove(val, val + map->value_bytes, (map->size - find - 1) * map->value_bytes);
-            
-            bucket_remove(&bucket, search);
-            buckets_reindex(map->indices, map->mod, find);
-            --map->size;
-            return 1;
+    }
+
+    if (map->mode->rehash_index == map->mode->rehash_mod) {
+        free(map->mode->rehash);
+        map->mode->rehash = NULL;
+        map->mode->rehash_mod = 0;
+        map->mode->rehash_index = 0;
+    }
+}
+
+static void map_grow(struct map* map)
+{
+    const size_t mod = map->mod * 2;
+    struct mapmode* mode = map_mode(map);
+    if (mode->rehash) {
+        map_rehash(map, mode->rehash_mod);
+    }
+
+    map->hashes = realloc(map->hashes, mod * sizeof(size_t));
+    map->keys = realloc(map->keys, mod * map->key_bytes);
+    map->values = realloc(map->values, mod * map->value_bytes);
+    
+    mode->rehash = map->indices;
+    mode->rehash_mod = map->mod;
+    mode->rehash_index = 0;
+    map->indices = calloc(mod, sizeof(size_t*));
+    map->mod = mod;
+    ++mode->resizes;
+    if (mode->filter) {
+        map_filter_build(map);
+    }
+}
+
+/* Compact Index Implementation */
+
+#define MAP_LINK_MAX 0xFFFFFFFF
+#define MAP_LINK_NEXT(map, i) ((map)->mode->links + (map)->mod + (i))
+
+static unsigned int* map_link_search(const struct map* map, const void* key, const size_t hash,
+                                     int (*cmp)(const struct map*, const void*, const void*))
+{
+    unsigned int* link = map->mode->links + hash % map->mod;
+    while (*link) {
+        const size_t find = *link - 1;
+        MAP_STATS_COUNT(map, probes);
+        if (map->hashes[find] == hash && cmp(map, _map_key_at(map, find), key)) {
+            return link;
         }
+        link = MAP_LINK_NEXT(map, find);
     }
+    return NULL;
+}
 
-    return 0;
+static void map_link_push(struct map* map, const size_t index, const size_t hash)
+{
+    unsigned int* link = map->mode->links + hash % map->mod;
+    while (*link) {
+        link = MAP_LINK_NEXT(map, *link - 1);
+    }
+    *link = (unsigned int)(index + 1);
+    *MAP_LINK_NEXT(map, index) = 0;
 }
 
-void* map_push(struct map* map, const void* key, const void* value)
+static void map_link_build(struct map* map)
 {
-    void* ptr;
-    size_t hashmod;
-    if (map->size == map->mod) {
-        map_resize(map, map->mod * 2);
+    size_t i;
+    memset(map->mode->links, 0, map->mod * sizeof(unsigned int));
+    for (i = map->size; i; --i) {
+        unsigned int* head = map->mode->links + map->hashes[i - 1] % map->mod;
+        *MAP_LINK_NEXT(map, i - 1) = *head;
+        *head = (unsigned int)i;
+    }
+}
+
+static void map_prefetch(const struct map* map, const size_t hash)
+{
+    if (MAP_MODE(map, links)) {
+        UTOPIA_PREFETCH(map->mode->links + hash % map->mod);
+    }
+    else if (map->indices) {
+        UTOPIA_PREFETCH(map->indices + hash % map->mod);
     }
+}
 
-    hashmod = map->func(key) % map->mod;
-    map->indices[hashmod] = bucket_push(map->indices[hashmod], map->size);
+/* Perfect Hash Implementation */
 
-    ptr = _map_value_at(map, map->size);
-    memcpy(_map_key_at(map, map->size), key, map->key_bytes);
-    memcpy(ptr, value, map->value_bytes);
-    ++map->size;
-    return ptr;
+#ifndef UTOPIA_MAP_FREEZE_LAMBDA
+#define UTOPIA_MAP_FREEZE_LAMBDA 3
+#endif
+
+#ifndef UTOPIA_MAP_FREEZE_SLACK
+#define UTOPIA_MAP_FREEZE_SLACK 64
+#endif
+
+#define MAP_FREEZE_SEEDS 8
+#define MAP_FREEZE_RESEEDS 4
+#define MAP_FREEZE_GOLDEN 0x9E3779B9
+#define MAP_PILOT_ESCAPE 0xFF
+#define MAP_PILOT_RANGE(n) ((n) + (n) / UTOPIA_MAP_FREEZE_SLACK)
+#define MAP_PILOT_PAD(mod) (((mod) + sizeof(size_t) - 1) & ~(sizeof(size_t) - 1))
+#define MAP_PILOT_SPILL(pilots, mod) ((size_t*)((pilots) + MAP_PILOT_PAD(mod)))
+
+static size_t map_mix(size_t x)
+{
+    x = ((x >> 16) ^ x) * 0x45d9f3b;
+    x = ((x >> 16) ^ x) * 0x45d9f3b;
+    return (x >> 16) ^ x;
 }
 
-size_t map_push_if(struct map* map, const void* key, const void* value)
+#define MAP_PILOT_BUCKET(hash, seed, mod) (map_mix((hash) ^ (seed)) % (mod))
+#define MAP_PILOT_SLOT(hash, seed, pilot, n) \
+    (map_mix(map_mix(map_mix((hash) ^ (seed)) ^ MAP_FREEZE_GOLDEN) ^ ((pilot) * MAP_FREEZE_GOLDEN)) % (n))
+
+static size_t map_pilot_at(const unsigned char* pilots, const size_t mod, const size_t bucket)
 {
-    const size_t index = map_search(map, key);
-    if (index) {
-        return index;
+    size_t lo = 0, hi;
+    const size_t* spill = MAP_PILOT_SPILL(pilots, mod);
+    if (pilots[bucket] != MAP_PILOT_ESCAPE) {
+        return pilots[bucket];
+    }
+
+    hi = spill[0];
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (spill[1 + 2 * mid] < bucket) {
+            lo = mid + 1;
+        }
+        else hi = mid;
+    }
+    return spill[2 + 2 * lo];
+}
+
+static size_t map_pilot_bytes(const struct map* map)
+{
+    const size_t spills = MAP_PILOT_SPILL(map->mode->pilots, map->mode->pilot_mod)[0];
+    return MAP_PILOT_PAD(map->mode->pilot_mod) + 
+           (1 + 2 * spills + MAP_PILOT_RANGE(map->size) - map->size) * sizeof(size_t);
+}
+
+static size_t map_pilot_search(const struct map* map, const void* key, const size_t hash,
+                               int (*cmp)(const struct map*, const void*, const void*))
+{
+    size_t find;
+    const struct mapmode* mode = map->mode;
+    const size_t bucket = MAP_PILOT_BUCKET(hash, mode->pilot_seed, mode->pilot_mod);
+    if (!map->size) {
+        return 0;
+    }
+
+    find = MAP_PILOT_SLOT(hash, mode->pilot_seed, map_pilot_at(mode->pilots, mode->pilot_mod, bucket), 
+                          MAP_PILOT_RANGE(map->size));
+    if (find >= map->size) {
+        const size_t* spill = MAP_PILOT_SPILL(mode->pilots, mode->pilot_mod);
+        find = spill[1 + 2 * spill[0] + find - map->size];
     }
 
-    map_push(map, key, value);
+    MAP_STATS_COUNT(map, probes);
+    if (map->hashes[find] == hash && cmp(map, _map_key_at(map, find), key)) {
+        return find + 1;
+    }
     return 0;
 }
 
-void map_free(struct map* map)
+static int map_pilot_place(const struct map* map, const size_t* items, const size_t count, 
+                           const size_t seed, unsigned char* taken, size_t* slots, size_t* pilot)
 {
-    if (map->indices) {
-        buckets_free(map->indices, map->mod);
-        free(map->indices);
-        free(map->keys);
-        free(map->values);
+    size_t i, j, p;
+    const size_t n = MAP_PILOT_RANGE(map->size), tries = n * 64 + 1024;
+    for (i = 0; i < count; ++i) {
+        for (j = 0; j < i; ++j) {
+            if (map->hashes[items[i]] == map->hashes[items[j]]) {
+                return 0;
+            }
+        }
+    }
+
+    for (p = 0; p < tries; ++p) {
+        for (i = 0; i < count; ++i) {
+            slots[i] = MAP_PILOT_SLOT(map->hashes[items[i]], seed, p, n);
+            if (taken[slots[i]]) {
+                break;
+            }
+            taken[slots[i]] = 1;
+        }
+
+        if (i == count) {
+            *pilot = p;
+            return 1;
+        }
+
+        while (i--) {
+            taken[slots[i]] = 0;
+        }
+    }
+    return 0;
+}
 
-        map->indices = NULL;
-        map->keys = NULL;
-        map->values = NULL;
-        map->size = 0;
-        map->mod = 0;
+static unsigned char* map_pilot_build(const struct map* map, const size_t mod, const size_t seed, size_t* slots)
+{
+    size_t i, b, hole, max = 0, escapes = 0, *spill, *remap;
+    const size_t n = map->size, range = MAP_PILOT_RANGE(n);
+    unsigned char* bytes = NULL;
+    size_t* pilots = calloc(mod, sizeof(size_t));
+    size_t* starts = calloc(mod + 1, sizeof(size_t));
+    size_t* items = malloc(n * sizeof(size_t));
+    size_t* order = malloc(mod * sizeof(size_t));
+    size_t* cursor = malloc(mod * sizeof(size_t));
+    size_t* sizes;
+    size_t* placed = malloc(n * sizeof(size_t));
+    unsigned char* taken = calloc(range, 1);
+    int success = 1;
+
+    for (i = 0; i < n; ++i) {
+        ++starts[MAP_PILOT_BUCKET(map->hashes[i], seed, mod) + 1];
     }
+
+    for (b = 0; b < mod; ++b) {
+        max = starts[b + 1] > max ? starts[b + 1] : max;
+        starts[b + 1] += starts[b];
+    }
+
+    memcpy(cursor, starts, mod * sizeof(size_t));
+    for (i = 0; i < n; ++i) {
+        items[cursor[MAP_PILOT_BUCKET(map->hashes[i], seed, mod)]++] = i;
+    }
+
+    sizes = calloc(max + 2, sizeof(size_t));
+    for (b = 0; b < mod; ++b) {
+        ++sizes[max - (starts[b + 1] - starts[b]) + 1];
+    }
+
+    for (i = 0; i < max + 1; ++i) {
+        sizes[i + 1] += sizes[i];
+    }
+
+    for (b = 0; b < mod; ++b) {
+        order[sizes[max - (starts[b + 1] - starts[b])]++] = b;
+    }
+
+    for (i = 0; i < mod && success; ++i) {
+        b = order[i];
+        success = map_pilot_place(map, items + starts[b], starts[b + 1] - starts[b], 
+                                  seed, taken, placed + starts[b], pilots + b);
+    }
+
+    if (success) {
+        for (b = 0; b < mod; ++b) {
+            escapes += pilots[b] >= MAP_PILOT_ESCAPE;
+        }
+
+        bytes = malloc(MAP_PILOT_PAD(mod) + (1 + 2 * escapes + range - n) * sizeof(size_t));
+        spill = MAP_PILOT_SPILL(bytes, mod);
+        spill[0] = 0;
+        for (b = 0; b < mod; ++b) {
+            bytes[b] = (unsigned char)(pilots[b] < MAP_PILOT_ESCAPE ? pilots[b] : MAP_PILOT_ESCAPE);
+            if (pilots[b] >= MAP_PILOT_ESCAPE) {
+                spill[1 + 2 * spill[0]] = b;
+                spill[2 + 2 * spill[0]++] = pilots[b];
+            }
+        }
+
+        remap = spill + 1 + 2 * escapes;
+        for (i = n, hole = 0; i < range; ++i) {
+            remap[i - n] = 0;
+            if (taken[i]) {
+                while (taken[hole]) {
+                    ++hole;
+                }
+                remap[i - n] = hole++;
+            }
+        }
+
+        for (i = 0; i < n; ++i) {
+            slots[items[i]] = placed[i] < n ? placed[i] : remap[placed[i] - n];
+        }
+    }
+
+    free(placed);
+    free(taken);
+    free(sizes);
+    free(cursor);
+    free(order);
+    free(items);
+    free(starts);
+    free(pilots);
+    return success ? bytes : NULL;
+}
+
+/* Image Implementation */
+
+#define MAP_IMAGE_MAGIC 0x55544D50
+#define MAP_IMAGE_ALIGN(n) (((n) + 15) & ~(size_t)15)
+
+#define MAP_IMAGE_MAGIC_INDEX 0
+#define MAP_IMAGE_WORD_INDEX 1
+#define MAP_IMAGE_KEY_BYTES_INDEX 2
+#define MAP_IMAGE_VALUE_BYTES_INDEX 3
+#define MAP_IMAGE_SIZE_INDEX 4
+#define MAP_IMAGE_MOD_INDEX 5
+#define MAP_IMAGE_HASHES_INDEX 6
+#define MAP_IMAGE_KEYS_INDEX 7
+#define MAP_IMAGE_VALUES_INDEX 8
+#define MAP_IMAGE_PACKED_INDEX 9
+#define MAP_IMAGE_ARENA_INDEX 10
+#define MAP_IMAGE_ARENA_BYTES_INDEX 11
+#define MAP_IMAGE_BYTES_INDEX 12
+#define MAP_IMAGE_HEADER 13
+
+static void* map_image_open(const char* path, size_t* bytes)
+{
+    void* image;
+#ifdef UTOPIA_MMAP
+    struct stat st;
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    if (fstat(fd, &st) || !st.st_size) {
+        close(fd);
+        return NULL;
+    }
+
+    *bytes = (size_t)st.st_size;
+    image = mmap(NULL, *bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    return image == MAP_FAILED ? NULL : image;
+#else
+    long size;
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    image = size > 0 ? malloc(size) : NULL;
+    if (image && fread(image, 1, size, file) != (size_t)size) {
+        free(image);
+        image = NULL;
+    }
+
+    fclose(file);
+    *bytes = (size_t)size;
+    return image;
+#endif
+}
+
+static void map_image_close(void* image, const size_t bytes)
+{
+#ifdef UTOPIA_MMAP
+    munmap(image, bytes);
+#else
+    (void)bytes;
+    free(image);
+#endif
+}
+
+#define MAP_IMAGE_FITS(bytes, offset, count, width) \
+    ((offset) <= (bytes) && !((offset) % sizeof(size_t)) && (count) <= ((bytes) - (offset)) / (width))
+
+static int map_image_slices(const struct mapslice* slices, const size_t count, const size_t arena)
+{
+    size_t i;
+    for (i = 0; i < count; ++i) {
+        if (slices[i].offset > arena || slices[i].length > arena - slices[i].offset) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int map_image_check(const char* image, const size_t bytes)
+{
+    size_t i;
+    const size_t* header = (const size_t*)image;
+    const size_t* packed;
+    size_t size, mod, arena;
+    if (bytes < MAP_IMAGE_HEADER * sizeof(size_t) ||
+        header[MAP_IMAGE_MAGIC_INDEX] != MAP_IMAGE_MAGIC ||
+        header[MAP_IMAGE_WORD_INDEX] != sizeof(size_t) ||
+        header[MAP_IMAGE_BYTES_INDEX] != bytes ||
+        !header[MAP_IMAGE_KEY_BYTES_INDEX] || !header[MAP_IMAGE_VALUE_BYTES_INDEX]) {
+        return 0;
+    }
+
+    size = header[MAP_IMAGE_SIZE_INDEX];
+    mod = header[MAP_IMAGE_MOD_INDEX];
+    arena = header[MAP_IMAGE_ARENA_BYTES_INDEX];
+    if (size > bytes || mod > bytes || (size && !mod) ||
+        !MAP_IMAGE_FITS(bytes, header[MAP_IMAGE_HASHES_INDEX], size, sizeof(size_t)) ||
+        !MAP_IMAGE_FITS(bytes, header[MAP_IMAGE_KEYS_INDEX], size, header[MAP_IMAGE_KEY_BYTES_INDEX]) ||
+        !MAP_IMAGE_FITS(bytes, header[MAP_IMAGE_VALUES_INDEX], size, header[MAP_IMAGE_VALUE_BYTES_INDEX]) ||
+        !MAP_IMAGE_FITS(bytes, header[MAP_IMAGE_PACKED_INDEX], mod + 1 + size, sizeof(size_t)) ||
+        !MAP_IMAGE_FITS(bytes, header[MAP_IMAGE_ARENA_INDEX], arena, 1)) {
+        return 0;
+    }
+
+    packed = (const size_t*)(image + header[MAP_IMAGE_PACKED_INDEX]);
+    if (packed[0] || packed[mod] != size) {
+        return 0;
+    }
+
+    for (i = 0; i < mod; ++i) {
+        if (packed[i] > packed[i + 1]) {
+            return 0;
+        }
+    }
+
+    for (i = 0; i < size; ++i) {
+        if (packed[mod + 1 + i] >= size) {
+            return 0;
+        }
+    }
+
+    if (arena) {
+        return header[MAP_IMAGE_KEY_BYTES_INDEX] == sizeof(struct mapslice) &&
+               header[MAP_IMAGE_VALUE_BYTES_INDEX] == sizeof(struct mapslice) &&
+               map_image_slices((const struct mapslice*)(image + header[MAP_IMAGE_KEYS_INDEX]), size, arena) &&
+               map_image_slices((const struct mapslice*)(image + header[MAP_IMAGE_VALUES_INDEX]), size, arena);
+    }
+    return 1;
+}
+
+static int map_image_write(FILE* file, size_t* pos, const size_t offset, 
+                           const void* data, const size_t bytes)
+{
+    static const char zeros[16] = {0};
+    if (fwrite(zeros, 1, offset - *pos, file) != offset - *pos ||
+        (bytes && fwrite(data, 1, bytes, file) != bytes)) {
+        return 0;
+    }
+    *pos = offset + bytes;
+    return 1;
+}
+
+static size_t map_packed_search(const struct map* map, const void* key, const size_t hash,
+                                int (*cmp)(const struct map*, const void*, const void*))
+{
+    const size_t hashmod = hash % map->mod;
+    const size_t* entries = map->mode->packed + map->mod + 1;
+    size_t i = map->mode->packed[hashmod];
+    const size_t end = map->mode->packed[hashmod + 1];
+    for (; i < end; ++i) {
+        const size_t find = entries[i];
+        MAP_STATS_COUNT(map, probes);
+        if (map->hashes[find] == hash && cmp(map, _map_key_at(map, find), key)) {
+            return find + 1;
+        }
+    }
+    return 0;
+}
+
+#define MAP_SMALL_LANES (16 / sizeof(size_t))
+
+static unsigned long map_small_match(const size_t* hashes, const size_t size, const size_t hash)
+{
+    size_t i = 0;
+    unsigned long mask = 0;
+#ifdef UTOPIA_MAP_SSE2
+    size_t lanes[MAP_SMALL_LANES];
+    __m128i needle;
+    for (i = 0; i < MAP_SMALL_LANES; ++i) {
+        lanes[i] = hash;
+    }
+    needle = _mm_loadu_si128((const __m128i*)lanes);
+    for (i = 0; i + MAP_SMALL_LANES <= size; i += MAP_SMALL_LANES) {
+        const __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(hashes + i)), needle);
+        unsigned long bits = (unsigned long)_mm_movemask_ps(_mm_castsi128_ps(eq));
+        if (MAP_SMALL_LANES == 2) {
+            bits &= bits >> 1;
+            bits = (bits & 1) | ((bits >> 1) & 2);
+        }
+        mask |= bits << i;
+    }
+#endif
+    for (; i < size; ++i) {
+        mask |= (unsigned long)(hashes[i] == hash) << i;
+    }
+    return mask;
+}
+
+static size_t map_small_search(const struct map* map, const void* key, const size_t hash,
+                               int (*cmp)(const struct map*, const void*, const void*))
+{
+    size_t i;
+    unsigned long mask = map_small_match(map->hashes, map->size, hash);
+    for (i = 0; mask; ++i, mask >>= 1) {
+        if (mask & 1) {
+            MAP_STATS_COUNT(map, probes);
+            if (cmp(map, _map_key_at(map, i), key)) {
+                return i + 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static void map_small_reserve(struct map* map)
+{
+    map->mod = UTOPIA_MAP_SMALL;
+    map->hashes = realloc(map->hashes, map->mod * sizeof(size_t));
+    map->keys = realloc(map->keys, map->mod * map->key_bytes);
+    map->values = realloc(map->values, map->mod * map->value_bytes);
+    MAP_STATS_MODE(map);
+}
+
+static size_t map_bucket_search(const struct map* map, const size_t* bucket, const void* key, 
+                                const size_t hash, int (*cmp)(const struct map*, const void*, const void*))
+{
+    size_t i;
+    const size_t size = BUCKET_SIZE(bucket) + BUCKET_DATA_INDEX;
+    for (i = BUCKET_DATA_INDEX; i < size; ++i) {
+        const size_t find = bucket[i];
+        MAP_STATS_COUNT(map, probes);
+        if (map->hashes[find] == hash && cmp(map, _map_key_at(map, find), key)) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+static size_t map_find(const struct map* map, const void* key, const size_t hash, 
+                       int (*cmp)(const struct map*, const void*, const void*))
+{
+    const struct mapmode* mode = map->mode;
+    if (mode) {
+        if (mode->filter && !filter_query(mode->filter, hash)) {
+            return 0;
+        }
+
+        if (mode->packed) {
+            return map->mod ? map_packed_search(map, key, hash, cmp) : 0;
+        }
+
+        if (mode->pilots) {
+            return map_pilot_search(map, key, hash, cmp);
+        }
+
+        if (mode->links) {
+            const unsigned int* link = map_link_search(map, key, hash, cmp);
+            return link ? *link : 0;
+        }
+    }
+
+    if (MAP_SMALL(map)) {
+        return map_small_search(map, key, hash, cmp);
+    }
+    
+    if (map->mod) {
+        const size_t* bucket = *map_bucket(map, hash);
+        const size_t search = map_bucket_search(map, bucket, key, hash, cmp);
+        if (search) {
+            return bucket[search] + 1;
+        }
+    }
+
+    return 0;
+}
+
+static int map_link_erase(struct map* map, const void* key, const size_t hash, 
+                          int (*cmp)(const struct map*, const void*, const void*))
+{
+    size_t i;
+    unsigned int* link = map_link_search(map, key, hash, cmp);
+    if (link) {
+        const size_t find = *link - 1;
+        const size_t count = map->size - find - 1;
+        char* k = _map_key_at(map, find);
+        char* v = _map_value_at(map, find);
+        
+        *link = *MAP_LINK_NEXT(map, find);
+        memmove(k, k + map->key_bytes, count * map->key_bytes);
+        memmove(v, v + map->value_bytes, count * map->value_bytes);
+        memmove(map->hashes + find, map->hashes + find + 1, count * sizeof(size_t));
+        memmove(MAP_LINK_NEXT(map, find), MAP_LINK_NEXT(map, find + 1), count * sizeof(unsigned int));
+        
+        for (i = 0; i < map->mod + map->size - 1; ++i) {
+            map->mode->links[i] -= (map->mode->links[i] > find);
+        }
+        --map->size;
+        return 1;
+    }
+
+    return 0;
+}
+
+static int map_link_erase_swap(struct map* map, const void* key, const size_t hash, 
+                               int (*cmp)(const struct map*, const void*, const void*))
+{
+    unsigned int* link = map_link_search(map, key, hash, cmp);
+    if (link) {
+        const size_t find = *link - 1;
+        const size_t last = --map->size;
+        
+        *link = *MAP_LINK_NEXT(map, find);
+        if (find != last) {
+            link = map->mode->links + map->hashes[last] % map->mod;
+            while (*link != last + 1) {
+                link = MAP_LINK_NEXT(map, *link - 1);
+            }
+
+            *link = (unsigned int)(find + 1);
+            *MAP_LINK_NEXT(map, find) = *MAP_LINK_NEXT(map, last);
+            map->hashes[find] = map->hashes[last];
+            memcpy(_map_key_at(map, find), _map_key_at(map, last), map->key_bytes);
+            memcpy(_map_value_at(map, find), _map_value_at(map, last), map->value_bytes);
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+static int map_small_erase(struct map* map, const void* key, const size_t hash, 
+                           int (*cmp)(const struct map*, const void*, const void*), const int swap)
+{
+    const size_t search = map_small_search(map, key, hash, cmp);
+    if (search) {
+        const size_t find = search - 1;
+        const size_t last = --map->size;
+        char* k = _map_key_at(map, find);
+        char* v = _map_value_at(map, find);
+        if (swap) {
+            map->hashes[find] = map->hashes[last];
+            memcpy(k, _map_key_at(map, last), map->key_bytes);
+            memcpy(v, _map_value_at(map, last), map->value_bytes);
+        }
+        else {
+            const size_t count = last - find;
+            memmove(k, k + map->key_bytes, count * map->key_bytes);
+            memmove(v, v + map->value_bytes, count * map->value_bytes);
+            memmove(map->hashes + find, map->hashes + find + 1, count * sizeof(size_t));
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+static int map_erase(struct map* map, const void* key, const size_t hash, 
+                     int (*cmp)(const struct map*, const void*, const void*))
+{
+    size_t** bucketref;
+    size_t search;
+    if (MAP_MODE(map, links)) {
+        return map_link_erase(map, key, hash, cmp);
+    }
+
+    if (MAP_SMALL(map)) {
+        return map_small_erase(map, key, hash, cmp, 0);
+    }
+
+    bucketref = map_bucket(map, hash);
+    search = map_bucket_search(map, *bucketref, key, hash, cmp);
+    if (search) {
+        const size_t find = (*bucketref)[search];
+        const size_t count = map->size - find - 1;
+        
+        char* k = _map_key_at(map, find);
+        char* v = _map_value_at(map, find);
+        memmove(k, k + map->key_bytes, count * map->key_bytes);
+        memmove(v, v + map->value_bytes, count * map->value_bytes);
+        memmove(map->hashes + find, map->hashes + find + 1, count * sizeof(size_t));
+        
+        bucket_remove(bucketref, search);
+        buckets_reindex(map->indices, map->mod, find);
+        if (MAP_MODE(map, rehash)) {
+            buckets_reindex(map->mode->rehash, map->mode->rehash_mod, find);
+        }
+        --map->size;
+        return 1;
+    }
+
+    return 0;
+}
+
+static int map_erase_swap(struct map* map, const void* key, const size_t hash, 
+                          int (*cmp)(const struct map*, const void*, const void*))
+{
+    size_t** bucketref;
+    size_t search;
+    if (MAP_MODE(map, links)) {
+        return map_link_erase_swap(map, key, hash, cmp);
+    }
+
+    if (MAP_SMALL(map)) {
+        return map_small_erase(map, key, hash, cmp, 1);
+    }
+
+    bucketref = map_bucket(map, hash);
+    search = map_bucket_search(map, *bucketref, key, hash, cmp);
+    if (search) {
+        const size_t find = (*bucketref)[search];
+        const size_t last = --map->size;
+        
+        bucket_remove(bucketref, search);
+        if (find != last) {
+            size_t i = BUCKET_DATA_INDEX;
+            size_t* bucket = *map_bucket(map, map->hashes[last]);
+            while (bucket[i] != last) {
+                ++i;
+            }
+
+            bucket[i] = find;
+            map->hashes[find] = map->hashes[last];
+            memcpy(_map_key_at(map, find), _map_key_at(map, last), map->key_bytes);
+            memcpy(_map_value_at(map, find), _map_value_at(map, last), map->value_bytes);
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+/* Parallel Build Implementation */
+
+struct mapbuild {
+    struct map* map;
+    const char* keys;
+    const char* values;
+    size_t* counts;
+    size_t* order;
+    size_t base;
+    size_t count;
+    size_t threads;
+    size_t thread;
+};
+
+#define MAP_BUILD_CHUNK(n, t) (((n) + (t) - 1) / (t))
+#define MAP_BUILD_BEGIN(b) ((b)->thread * MAP_BUILD_CHUNK((b)->count, (b)->threads))
+#define MAP_BUILD_END(b) (MAP_BUILD_BEGIN(b) + MAP_BUILD_CHUNK((b)->count, (b)->threads) < (b)->count ? \
+                          MAP_BUILD_BEGIN(b) + MAP_BUILD_CHUNK((b)->count, (b)->threads) : (b)->count)
+#define MAP_BUILD_PART(b, hash) ((hash) % (b)->map->mod / MAP_BUILD_CHUNK((b)->map->mod, (b)->threads))
+
+static void* map_build_hash(void* arg)
+{
+    struct mapbuild* b = arg;
+    struct map* map = b->map;
+    size_t i, *counts = b->counts + b->thread * b->threads;
+    const size_t begin = MAP_BUILD_BEGIN(b), end = MAP_BUILD_END(b);
+    
+    if (begin < end) {
+        memcpy(_map_key_at(map, b->base + begin), b->keys + begin * map->key_bytes, 
+               (end - begin) * map->key_bytes);
+        memcpy(_map_value_at(map, b->base + begin), b->values + begin * map->value_bytes, 
+               (end - begin) * map->value_bytes);
+    }
+
+    for (i = begin; i < end; ++i) {
+        const size_t hash = MAP_HASH(map, b->keys + i * map->key_bytes);
+        map->hashes[b->base + i] = hash;
+        ++counts[MAP_BUILD_PART(b, hash)];
+    }
+    return NULL;
+}
+
+static void* map_build_scatter(void* arg)
+{
+    struct mapbuild* b = arg;
+    size_t i, *offsets = b->counts + b->thread * b->threads;
+    const size_t end = MAP_BUILD_END(b);
+    for (i = MAP_BUILD_BEGIN(b); i < end; ++i) {
+        b->order[offsets[MAP_BUILD_PART(b, b->map->hashes[b->base + i])]++] = b->base + i;
+    }
+    return NULL;
+}
+
+static void* map_build_buckets(void* arg)
+{
+    struct mapbuild* b = arg;
+    struct map* map = b->map;
+    const size_t* ends = b->counts + (b->threads - 1) * b->threads;
+    size_t i = b->thread ? ends[b->thread - 1] : 0;
+    for (; i < ends[b->thread]; ++i) {
+        const size_t hashmod = map->hashes[b->order[i]] % map->mod;
+        if (MAP_MODE(map, links)) {
+            map_link_push(map, b->order[i], map->hashes[b->order[i]]);
+        }
+        else map->indices[hashmod] = bucket_push(map->indices[hashmod], b->order[i]);
+    }
+    return NULL;
+}
+
+static void map_build_run(struct mapbuild* builds, void* (*worker)(void*))
+{
+    size_t i;
+    const size_t threads = builds->threads;
+#ifdef UTOPIA_MAP_THREADS
+    pthread_t* handles = malloc(threads * sizeof(pthread_t));
+    int* spawned = calloc(threads, sizeof(int));
+    for (i = 1; i < threads; ++i) {
+        spawned[i] = !pthread_create(handles + i, NULL, worker, builds + i);
+        if (!spawned[i]) {
+            worker(builds + i);
+        }
+    }
+
+    worker(builds);
+    for (i = 1; i < threads; ++i) {
+        if (spawned[i]) {
+            pthread_join(handles[i], NULL);
+        }
+    }
+
+    free(spawned);
+    free(handles);
+#else
+    for (i = 0; i < threads; ++i) {
+        worker(builds + i);
+    }
+#endif
+}
+
+/* Arena Implementation */
+
+#define MAP_ARENA_ALIGN(n) (((n) + sizeof(size_t) - 1) & ~(sizeof(size_t) - 1))
+
+struct mapprobe {
+    const void* data;
+    size_t length;
+};
+
+static size_t map_arena_hash(const struct map* map, const void* data, const size_t length)
+{
+    size_t i, hash = 5381;
+    const unsigned char* str = data;
+    if (map->seeded) {
+        return map->seeded(data, length, map->seed);
+    }
+
+    for (i = 0; i < length; ++i) {
+        hash = ((hash << 5) + hash) + str[i];
+    }
+    return hash;
+}
+
+static int map_arena_equal(const struct map* map, const void* a, const void* b)
+{
+    const struct mapslice* slice = a;
+    const struct mapprobe* probe = b;
+    return slice->length == probe->length && 
+           !memcmp(map->mode->arena + slice->offset, probe->data, probe->length);
+}
+
+static size_t map_arena_copy(char* arena, size_t* size, const void* data, const size_t bytes)
+{
+    const size_t offset = MAP_ARENA_ALIGN(*size);
+    memcpy(arena + offset, data, bytes);
+    *size = offset + bytes;
+    return offset;
+}
+
+static void map_arena_reserve(struct map* map, const size_t bytes)
+{
+    struct mapmode* mode = map_mode(map);
+    size_t i, live = bytes, cap = mode->arena_cap + !mode->arena_cap * UTOPIA_HASH_SIZE * 8;
+    struct mapslice* keys = map->keys, *values = map->values;
+    char* arena;
+
+    for (i = 0; i < map->size; ++i) {
+        live += MAP_ARENA_ALIGN(keys[i].length) + MAP_ARENA_ALIGN(values[i].length);
+    }
+
+    while (cap < 2 * live) {
+        cap *= 2;
+    }
+
+    arena = malloc(cap);
+    for (live = 0, i = 0; i < map->size; ++i) {
+        keys[i].offset = map_arena_copy(arena, &live, mode->arena + keys[i].offset, keys[i].length);
+        values[i].offset = map_arena_copy(arena, &live, mode->arena + values[i].offset, values[i].length);
+    }
+
+    free(mode->arena);
+    mode->arena = arena;
+    mode->arena_size = live;
+    mode->arena_cap = cap;
+}
+
+struct map map_create(const size_t key_size, const size_t value_size)
+{
+    struct map map;
+    map.indices = NULL;
+    map.hashes = NULL;
+    map.keys = NULL;
+    map.values = NULL;
+    map.shared = NULL;
+    map.mode = NULL;
+    map.key_bytes = key_size + !key_size;
+    map.value_bytes = value_size + !value_size;
+    map.size = 0;
+    map.mod = 0;
+    map.compact = 0;
+    map.seed = 0;
+    map.func = &hash_default;
+    map.seeded = NULL;
+    map.eq = &equal_default;
+    return map;
+}
+
+struct map map_reserve(const size_t key_size, const size_t value_size, const size_t reserve)
+{
+    struct map map = map_create(key_size, value_size);
+    MAP_STATS_MODE(&map);
+    map.indices = reserve ? calloc(reserve, sizeof(size_t*)) : NULL;
+    map.hashes = reserve ? malloc(reserve * sizeof(size_t)) : NULL;
+    map.keys = reserve ? malloc(reserve * map.key_bytes) : NULL;
+    map.values = reserve ? malloc(reserve * map.value_bytes) : NULL;
+    map.mod = reserve;
+    return map;
+}
+
+struct map map_create_arena(void)
+{
+    return map_create(sizeof(struct mapslice), sizeof(struct mapslice));
+}
+
+struct map map_create_compact(const size_t key_size, const size_t value_size)
+{
+    struct map map = map_create(key_size, value_size);
+    map.compact = 1;
+    return map;
+}
+
+struct map map_from_arrays(const size_t key_size, const size_t value_size, const void* keys, 
+                           const void* values, const size_t count, const size_t nthreads)
+{
+    struct map map = map_create(key_size, value_size);
+    map_push_arrays(&map, keys, values, count, nthreads);
+    return map;
+}
+
+struct map map_copy(const struct map* map)
+{
+    struct map m = *map;
+    const struct mapmode* mode = map->mode;
+    m.shared = NULL;
+    m.mode = mode ? memdup(mode, sizeof(struct mapmode)) : NULL;
+    if (mode && mode->filter) {
+        m.mode->filter = filter_copy(mode->filter);
+    }
+
+    if (MAP_MODE(map, image)) {
+        m.hashes = memdup(map->hashes, map->size * sizeof(size_t));
+        m.keys = memdup(map->keys, map->size * map->key_bytes);
+        m.values = memdup(map->values, map->size * map->value_bytes);
+        m.mode->arena = mode->arena ? memdup(mode->arena, mode->arena_size) : NULL;
+        m.mode->arena_cap = mode->arena_size;
+        m.mode->packed = NULL;
+        m.mode->image = NULL;
+        m.mode->image_bytes = 0;
+        m.indices = NULL;
+        m.mod = 0;
+        map_resize(&m, map->mod);
+        m.mode->resizes = mode->resizes;
+    }
+    else if (map->mod) {
+        m.hashes = memdup(map->hashes, map->mod * sizeof(size_t));
+        m.keys = memdup(map->keys, map->mod * map->key_bytes);
+        m.values = memdup(map->values, map->mod * map->value_bytes);
+        m.indices = map->indices ? map_buckets_copy(map->indices, map->mod) : NULL;
+        if (mode) {
+            m.mode->links = mode->links ? memdup(mode->links, 2 * map->mod * sizeof(unsigned int)) : NULL;
+            m.mode->pilots = mode->pilots ? memdup(mode->pilots, map_pilot_bytes(map)) : NULL;
+            m.mode->arena = mode->arena ? memdup(mode->arena, mode->arena_cap) : NULL;
+            m.mode->rehash = mode->rehash ? map_buckets_copy(mode->rehash, mode->rehash_mod) : NULL;
+        }
+    }
+    return m;
+}
+
+struct map map_snapshot(struct map* map)
+{
+    if (!map->shared) {
+        map->shared = malloc(sizeof(size_t));
+        *map->shared = 1;
+    }
+
+    MAP_SHARED_ACQUIRE(map->shared);
+    return *map;
+}
+
+static void map_detach(struct map* map)
+{
+    size_t* shared = map->shared;
+    map->shared = NULL;
+    if (MAP_SHARED_LOAD(shared) > 1) {
+        struct map m = map_copy(map);
+        if (MAP_SHARED_RELEASE(shared)) {
+            *map = m;
+            return;
+        }
+
+        map_free(map);
+        *map = m;
+    }
+    free(shared);
+}
+
+static void map_unpack(struct map* map)
+{
+    struct map m = map_copy(map);
+    map_image_close(map->mode->image, map->mode->image_bytes);
+    free(map->mode->filter);
+    free(map->mode);
+    *map = m;
+}
+
+struct map map_open_mmap(const char* path)
+{
+    size_t bytes = 0;
+    const size_t* header;
+    struct mapmode* mode;
+    struct map map = map_create(0, 0);
+    char* image = map_image_open(path, &bytes);
+    if (!image) {
+        return map;
+    }
+
+    header = (const size_t*)image;
+    if (!map_image_check(image, bytes)) {
+        map_image_close(image, bytes);
+        return map;
+    }
+
+    map.key_bytes = header[MAP_IMAGE_KEY_BYTES_INDEX];
+    map.value_bytes = header[MAP_IMAGE_VALUE_BYTES_INDEX];
+    map.size = header[MAP_IMAGE_SIZE_INDEX];
+    map.mod = header[MAP_IMAGE_MOD_INDEX];
+    map.hashes = (size_t*)(image + header[MAP_IMAGE_HASHES_INDEX]);
+    map.keys = image + header[MAP_IMAGE_KEYS_INDEX];
+    map.values = image + header[MAP_IMAGE_VALUES_INDEX];
+    mode = map_mode(&map);
+    mode->packed = (size_t*)(image + header[MAP_IMAGE_PACKED_INDEX]);
+    if (header[MAP_IMAGE_ARENA_BYTES_INDEX]) {
+        mode->arena = image + header[MAP_IMAGE_ARENA_INDEX];
+        mode->arena_size = header[MAP_IMAGE_ARENA_BYTES_INDEX];
+    }
+    mode->image = image;
+    mode->image_bytes = bytes;
+    return map;
+}
+
+int map_save(const struct map* map, const char* path)
+{
+    FILE* file;
+    int success;
+    size_t i, pos = 0, header[MAP_IMAGE_HEADER];
+    const size_t mod = map->mod, size = map->size;
+    size_t* packed = calloc(mod + 1 + size, sizeof(size_t));
+    size_t* cursor = malloc((mod + 1) * sizeof(size_t));
+
+    for (i = 0; i < size; ++i) {
+        ++packed[map->hashes[i] % mod + 1];
+    }
+
+    for (i = 0; i < mod; ++i) {
+        packed[i + 1] += packed[i];
+    }
+
+    memcpy(cursor, packed, (mod + 1) * sizeof(size_t));
+    for (i = 0; i < size; ++i) {
+        packed[mod + 1 + cursor[map->hashes[i] % mod]++] = i;
+    }
+    free(cursor);
+
+    header[MAP_IMAGE_MAGIC_INDEX] = MAP_IMAGE_MAGIC;
+    header[MAP_IMAGE_WORD_INDEX] = sizeof(size_t);
+    header[MAP_IMAGE_KEY_BYTES_INDEX] = map->key_bytes;
+    header[MAP_IMAGE_VALUE_BYTES_INDEX] = map->value_bytes;
+    header[MAP_IMAGE_SIZE_INDEX] = size;
+    header[MAP_IMAGE_MOD_INDEX] = mod;
+    header[MAP_IMAGE_HASHES_INDEX] = MAP_IMAGE_ALIGN(sizeof(header));
+    header[MAP_IMAGE_KEYS_INDEX] = MAP_IMAGE_ALIGN(header[MAP_IMAGE_HASHES_INDEX] + size * sizeof(size_t));
+    header[MAP_IMAGE_VALUES_INDEX] = MAP_IMAGE_ALIGN(header[MAP_IMAGE_KEYS_INDEX] + size * map->key_bytes);
+    header[MAP_IMAGE_PACKED_INDEX] = MAP_IMAGE_ALIGN(header[MAP_IMAGE_VALUES_INDEX] + size * map->value_bytes);
+    header[MAP_IMAGE_ARENA_INDEX] = MAP_IMAGE_ALIGN(header[MAP_IMAGE_PACKED_INDEX] + (mod + 1 + size) * sizeof(size_t));
+    header[MAP_IMAGE_ARENA_BYTES_INDEX] = MAP_MODE(map, arena_size);
+    header[MAP_IMAGE_BYTES_INDEX] = header[MAP_IMAGE_ARENA_INDEX] + MAP_MODE(map, arena_size);
+
+    file = fopen(path, "wb");
+    success = file &&
+        map_image_write(file, &pos, 0, header, sizeof(header)) &&
+        map_image_write(file, &pos, header[MAP_IMAGE_HASHES_INDEX], map->hashes, size * sizeof(size_t)) &&
+        map_image_write(file, &pos, header[MAP_IMAGE_KEYS_INDEX], map->keys, size * map->key_bytes) &&
+        map_image_write(file, &pos, header[MAP_IMAGE_VALUES_INDEX], map->values, size * map->value_bytes) &&
+        map_image_write(file, &pos, header[MAP_IMAGE_PACKED_INDEX], packed, (mod + 1 + size) * sizeof(size_t)) &&
+        map_image_write(file, &pos, header[MAP_IMAGE_ARENA_INDEX], MAP_MODE(map, arena), MAP_MODE(map, arena_size));
+
+    if (file && fclose(file)) {
+        success = 0;
+    }
+
+    free(packed);
+    return success;
+}
+
+size_t map_capacity(const struct map* map)
+{
+    return map->mod;
+}
+
+void map_overload(struct map* map, size_t (*func)(const void*))
+{
+    map->func = func;
+    map->seeded = NULL;
+    if (map->eq == &equal_default) {
+        map->eq = NULL;
+    }
+}
+
+void map_overload_eq(struct map* map, int (*eq)(const void*, const void*))
+{
+    map->eq = eq;
+}
+
+void map_overload_seeded(struct map* map, size_t (*seeded)(const void*, size_t, size_t), size_t seed)
+{
+    map->seeded = seeded;
+    map->seed = seed;
+    if (map->eq == &equal_default) {
+        map->eq = NULL;
+    }
+}
+
+void map_filter(struct map* map, const double rate)
+{
+    if (map->shared) {
+        map_detach(map);
+    }
+
+    if (map->mode) {
+        free(map->mode->filter);
+        map->mode->filter = NULL;
+    }
+
+    if (rate > 0.0 && rate < 1.0) {
+        map_mode(map)->filter = filter_alloc(FILTER_BLOOM, 1, 1, filter_bits(rate));
+        map_filter_build(map);
+    }
+}
+
+void* map_key_at(const struct map* map, const size_t index)
+{
+    return _map_key_at(map, index);
+}
+
+void* map_value_at(const struct map* map, const size_t index)
+{
+    return _map_value_at(map, index);
+}
+
+void* map_value_mut(struct map* map, const size_t index)
+{
+    if (map->shared) {
+        map_detach(map);
+    }
+
+    if (MAP_MODE(map, image)) {
+        map_unpack(map);
+    }
+
+    return _map_value_at(map, index);
+}
+
+size_t map_size(const struct map* map)
+{
+    return map->size;
+}
+
+size_t map_key_bytes(const struct map* map)
+{
+    return map->key_bytes;
+}
+
+size_t map_value_bytes(const struct map* map)
+{
+    return map->value_bytes;
+}
+
+static void map_stats_chain(struct map_stats* stats, const size_t count)
+{
+    ++stats->histogram[count < UTOPIA_STATS_BINS ? count : UTOPIA_STATS_BINS - 1];
+    stats->longest_chain = count > stats->longest_chain ? count : stats->longest_chain;
+    stats->hit_probes += 0.5 * (double)count * (double)(count + 1);
+    stats->miss_probes += (double)count;
+}
+
+static size_t map_stats_buckets(struct map_stats* stats, size_t** buckets, const size_t mod)
+{
+    size_t i, bytes = mod * sizeof(size_t*);
+    for (i = 0; i < mod; ++i) {
+        map_stats_chain(stats, BUCKET_SIZE(buckets[i]));
+        if (buckets[i]) {
+            bytes += (BUCKET_CAP(buckets[i]) + BUCKET_DATA_INDEX) * sizeof(size_t);
+        }
+    }
+    return bytes;
+}
+
+struct map_stats map_stats(const struct map* map)
+{
+    size_t i;
+    struct map_stats stats;
+    memset(&stats, 0, sizeof(stats));
+    stats.size = map->size;
+    stats.capacity = map->mod;
+    stats.rehash_pending = MAP_MODE(map, rehash) ? map->mode->rehash_mod - map->mode->rehash_index : 0;
+    stats.resizes = MAP_MODE(map, resizes);
+    stats.probes = MAP_MODE(map, probes);
+    stats.hash_calls = MAP_MODE(map, hash_calls);
+    
+    if (MAP_MODE(map, image)) {
+        stats.bytes = map->mode->image_bytes;
+        for (i = 0; i < map->mod; ++i) {
+            map_stats_chain(&stats, map->mode->packed[i + 1] - map->mode->packed[i]);
+        }
+    }
+    else if (map->mod) {
+        stats.bytes = map->mod * (sizeof(size_t) + map->key_bytes + map->value_bytes) + MAP_MODE(map, arena_cap);
+        if (MAP_MODE(map, pilots)) {
+            stats.bytes += map_pilot_bytes(map);
+            for (i = 0; i < map->size; ++i) {
+                map_stats_chain(&stats, 1);
+            }
+            stats.miss_probes = (double)map->mod;
+        }
+        else if (MAP_MODE(map, links)) {
+            stats.bytes += 2 * map->mod * sizeof(unsigned int);
+            for (i = 0; i < map->mod; ++i) {
+                size_t count = 0;
+                const unsigned int* link = map->mode->links + i;
+                for (; *link; link = MAP_LINK_NEXT(map, *link - 1)) {
+                    ++count;
+                }
+                map_stats_chain(&stats, count);
+            }
+        }
+        else if (map->indices) {
+            stats.bytes += map_stats_buckets(&stats, map->indices, map->mod);
+        }
+        else {
+            map_stats_chain(&stats, map->size);
+            stats.miss_probes = (double)map->mod * (double)map->size;
+        }
+        if (MAP_MODE(map, filter)) {
+            stats.bytes += FILTER_BYTES(map->mode->filter);
+        }
+        if (MAP_MODE(map, rehash)) {
+            stats.bytes += map_stats_buckets(&stats, map->mode->rehash, map->mode->rehash_mod);
+        }
+    }
+    if (map->mode) {
+        stats.bytes += sizeof(struct mapmode);
+    }
+
+    if (map->mod) {
+        stats.load_factor = (double)map->size / (double)map->mod;
+        stats.miss_probes /= (double)map->mod;
+    }
+
+    if (map->size) {
+        stats.hit_probes /= (double)map->size;
+    }
+
+    return stats;
+}
+
+void map_incremental(struct map* map, const size_t step)
+{
+    if (map->shared) {
+        map_detach(map);
+    }
+    map_mode(map)->rehash_step = step;
+}
+
+static int map_freeze_reseed(struct map* map)
+{
+    size_t i;
+    if (!map->seeded) {
+        return 0;
+    }
+
+    map->seed = map_mix(map->seed ^ MAP_FREEZE_GOLDEN) + 1;
+    for (i = 0; i < map->size; ++i) {
+        if (MAP_MODE(map, arena)) {
+            const struct mapslice* slice = (const struct mapslice*)_map_key_at(map, i);
+            map->hashes[i] = map_arena_hash(map, map->mode->arena + slice->offset, slice->length);
+        }
+        else map->hashes[i] = MAP_HASH(map, _map_key_at(map, i));
+    }
+
+    map_resize(map, map->mod);
+    return 1;
+}
+
+int map_freeze(struct map* map)
+{
+    size_t i, r, s, mod, seed = 0, *slots, *hashes;
+    unsigned char* pilots = NULL;
+    struct mapmode* mode;
+    char* keys, *values;
+
+    if (MAP_MODE(map, pilots)) {
+        return 1;
+    }
+
+    if (map->shared) {
+        map_detach(map);
+    }
+
+    if (MAP_MODE(map, image)) {
+        map_unpack(map);
+    }
+
+    if (!map->mod) {
+        map_resize(map, 0);
+    }
+
+    mod = map->size / UTOPIA_MAP_FREEZE_LAMBDA + 1;
+    slots = malloc((map->size + !map->size) * sizeof(size_t));
+    for (r = 0; r < MAP_FREEZE_RESEEDS && !pilots; ++r) {
+        for (s = 0; s < MAP_FREEZE_SEEDS && !pilots; ++s) {
+            seed = map_mix(s * MAP_FREEZE_GOLDEN + 1);
+            pilots = map_pilot_build(map, mod, seed, slots);
+        }
+
+        if (!pilots && !map_freeze_reseed(map)) {
+            break;
+        }
+    }
+
+    if (!pilots) {
+        free(slots);
+        return 0;
+    }
+
+    hashes = malloc(map->mod * sizeof(size_t));
+    keys = malloc(map->mod * map->key_bytes);
+    values = malloc(map->mod * map->value_bytes);
+    for (i = 0; i < map->size; ++i) {
+        hashes[slots[i]] = map->hashes[i];
+        memcpy(keys + slots[i] * map->key_bytes, _map_key_at(map, i), map->key_bytes);
+        memcpy(values + slots[i] * map->value_bytes, _map_value_at(map, i), map->value_bytes);
+    }
+
+    mode = map_mode(map);
+    if (mode->rehash) {
+        map_rehash(map, mode->rehash_mod);
+    }
+
+    if (map->indices) {
+        buckets_free(map->indices, map->mod);
+    }
+
+    free(slots);
+    free(map->indices);
+    free(mode->links);
+    free(map->hashes);
+    free(map->keys);
+    free(map->values);
+    map->indices = NULL;
+    mode->links = NULL;
+    map->hashes = hashes;
+    map->keys = keys;
+    map->values = values;
+    mode->pilots = pilots;
+    mode->pilot_mod = mod;
+    mode->pilot_seed = seed;
+    if (mode->filter) {
+        map_filter_build(map);
+    }
+    return 1;
+}
+
+void map_thaw(struct map* map)
+{
+    if (MAP_MODE(map, pilots)) {
+        map_resize(map, map->mod);
+    }
+}
+
+size_t map_search(const struct map* map, const void* data)
+{
+    MAP_STATS_COUNT(map, hash_calls);
+    return map->mod ? map_find(map, data, MAP_HASH(map, data), &map_key_equal) : 0;
+}
+
+void map_resize(struct map* map, const size_t new_size)
+{
+    size_t i;
+    const size_t size = map->size;
+
+    if (map->shared) {
+        map_detach(map);
+    }
+
+    if (MAP_MODE(map, image)) {
+        map_unpack(map);
+    }
+
+    if (MAP_MODE(map, pilots)) {
+        free(map->mode->pilots);
+        map->mode->pilots = NULL;
+        map->mode->pilot_mod = 0;
+    }
+
+    if (map->indices) {
+        buckets_free(map->indices, map->mod);
+    }
+
+    if (MAP_MODE(map, rehash)) {
+        buckets_free(map->mode->rehash, map->mode->rehash_mod);
+        free(map->mode->rehash);
+        map->mode->rehash = NULL;
+        map->mode->rehash_mod = 0;
+        map->mode->rehash_index = 0;
+    }
+
+    map->mod = new_size + !new_size * UTOPIA_HASH_SIZE;
+    map->hashes = realloc(map->hashes, map->mod * sizeof(size_t));
+    map->keys = realloc(map->keys, map->mod * map->key_bytes);
+    map->values = realloc(map->values, map->mod * map->value_bytes);
+    ++map_mode(map)->resizes;
+
+    if (MAP_MODE(map, filter)) {
+        map_filter_build(map);
+    }
+
+    if (map->compact && map->mod < MAP_LINK_MAX) {
+        struct mapmode* mode = map_mode(map);
+        mode->links = realloc(mode->links, 2 * map->mod * sizeof(unsigned int));
+        map_link_build(map);
+        return;
+    }
+
+    if (map->mode) {
+        free(map->mode->links);
+        map->mode->links = NULL;
+    }
+    map->compact = 0;
+    map->indices = realloc(map->indices, map->mod * sizeof(size_t*));
+    memset(map->indices, 0, map->mod * sizeof(size_t*));
+    
+    for (i = 0; i < size; ++i) {
+        const size_t hash_mod = map->hashes[i] % map->mod;
+        map->indices[hash_mod] = bucket_push(map->indices[hash_mod], i);
+    }
+}
+
+int map_remove(struct map* map, const void* key)
+{
+    if (map->shared) {
+        map_detach(map);
+    }
+
+    if (MAP_MODE(map, image)) {
+        map_unpack(map);
+    }
+    else if (MAP_MODE(map, pilots)) {
+        map_thaw(map);
+    }
+
+    return map->mod ? map_erase(map, key, MAP_HASH(map, key), &map_key_equal) : 0;
+}
+
+int map_remove_swap(struct map* map, const void* key)
+{
+    if (map->shared) {
+        map_detach(map);
+    }
+
+    if (MAP_MODE(map, image)) {
+        map_unpack(map);
+    }
+    else if (MAP_MODE(map, pilots)) {
+        map_thaw(map);
+    }
+
+    return map->mod ? map_erase_swap(map, key, MAP_HASH(map, key), &map_key_equal) : 0;
+}
+
+void map_search_batch(const struct map* map, const void* keys, const size_t count, size_t* indices)
+{
+    size_t i, j, n;
+    size_t hashes[UTOPIA_MAP_BATCH];
+    const size_t* buckets[UTOPIA_MAP_BATCH];
+    const char* key = keys;
+
+    if (!map->indices) {
+        for (i = 0; i < count; ++i, key += map->key_bytes) {
+            indices[i] = map_search(map, key);
+        }
+        return;
+    }
+
+    for (i = 0; i < count; i += n, key += n * map->key_bytes) {
+        n = count - i < UTOPIA_MAP_BATCH ? count - i : UTOPIA_MAP_BATCH;
+        
+        for (j = 0; j < n; ++j) {
+            hashes[j] = MAP_HASH(map, key + j * map->key_bytes);
+            MAP_STATS_COUNT(map, hash_calls);
+            if (MAP_MODE(map, filter)) {
+                UTOPIA_PREFETCH(FILTER_BLOOM_BLOCK(map->mode->filter, hashes[j]));
+            }
+            UTOPIA_PREFETCH(map->indices + hashes[j] % map->mod);
+            if (MAP_MODE(map, rehash)) {
+                UTOPIA_PREFETCH(map->mode->rehash + hashes[j] % map->mode->rehash_mod);
+            }
+        }
+
+        for (j = 0; j < n; ++j) {
+            if (MAP_MODE(map, filter) && !filter_query(map->mode->filter, hashes[j])) {
+                buckets[j] = NULL;
+                continue;
+            }
+            buckets[j] = *map_bucket(map, hashes[j]);
+            UTOPIA_PREFETCH(buckets[j]);
+        }
+
+        for (j = 0; j < n; ++j) {
+            if (buckets[j]) {
+                const size_t find = buckets[j][BUCKET_DATA_INDEX];
+                UTOPIA_PREFETCH(map->hashes + find);
+                UTOPIA_PREFETCH(_map_key_at(map, find));
+            }
+        }
+
+        for (j = 0; j < n; ++j) {
+            const size_t search = map_bucket_search(map, buckets[j], key + j * map->key_bytes, 
+                                                    hashes[j], &map_key_equal);
+            indices[i + j] = search ? buckets[j][search] + 1 : 0;
+        }
+    }
+}
+
+static void* map_push_hash(struct map* map, const void* key, const void* value, const size_t hash)
+{
+    void* ptr;
+    size_t hashmod;
+    if (map->shared) {
+        map_detach(map);
+    }
+
+    if (MAP_MODE(map, image)) {
+        map_unpack(map);
+    }
+    else if (MAP_MODE(map, pilots)) {
+        map_thaw(map);
+    }
+
+    if (map->size == map->mod) {
+        if (!map->mod && UTOPIA_MAP_SMALL) {
+            map_small_reserve(map);
+        }
+        else if (MAP_SMALL(map)) {
+            map_resize(map, UTOPIA_HASH_SIZE > map->mod * 2 ? UTOPIA_HASH_SIZE : map->mod * 2);
+        }
+        else if (MAP_MODE(map, rehash_step) && map->mod && !map->compact) {
+            map_grow(map);
+        }
+        else map_resize(map, map->mod * 2);
+    }
+
+    if (MAP_MODE(map, rehash)) {
+        hashmod = hash % map->mode->rehash_mod;
+        if (map->mode->rehash[hashmod]) {
+            map_rehash_bucket(map, hashmod);
+        }
+        map_rehash(map, map->mode->rehash_step);
+    }
+
+    if (MAP_MODE(map, links)) {
+        map_link_push(map, map->size, hash);
+    }
+    else if (map->indices) {
+        hashmod = hash % map->mod;
+        map->indices[hashmod] = bucket_push(map->indices[hashmod], map->size);
+    }
+    map->hashes[map->size] = hash;
+    if (MAP_MODE(map, filter)) {
+        filter_add(map->mode->filter, hash);
+    }
+
+    ptr = _map_value_at(map, map->size);
+    memcpy(_map_key_at(map, map->size), key, map->key_bytes);
+    memcpy(ptr, value, map->value_bytes);
+    ++map->size;
+    return ptr;
+}
+
+void* map_push(struct map* map, const void* key, const void* value)
+{
+    return map_push_hash(map, key, value, MAP_HASH(map, key));
+}
+
+void map_push_batch(struct map* map, const void* keys, const void* values,
+                    const size_t count, size_t* indices)
+{
+    size_t i, j, n;
+    size_t hashes[UTOPIA_MAP_BATCH];
+    const char* key = keys, *value = values;
+
+    if (!MAP_MODE(map, rehash_step) && map->size + count > map->mod) {
+        size_t mod = map->mod + !map->mod * UTOPIA_HASH_SIZE;
+        while (mod < map->size + count) {
+            mod *= 2;
+        }
+        map_resize(map, mod);
+    }
+
+    for (i = 0; i < count; i += n) {
+        n = count - i < UTOPIA_MAP_BATCH ? count - i : UTOPIA_MAP_BATCH;
+        
+        for (j = 0; j < n; ++j) {
+            hashes[j] = MAP_HASH(map, key + j * map->key_bytes);
+            map_prefetch(map, hashes[j]);
+        }
+
+        for (j = 0; j < n; ++j) {
+            if (indices) {
+                indices[i + j] = map->size;
+            }
+            map_push_hash(map, key, value, hashes[j]);
+            key += map->key_bytes;
+            value += map->value_bytes;
+        }
+    }
+}
+
+void map_push_arrays(struct map* map, const void* keys, const void* values, 
+                     const size_t count, const size_t nthreads)
+{
+    size_t i, j, sum, threads, mod = map->mod;
+    struct mapbuild* builds;
+    if (!count) {
+        return;
+    }
+    
+    if (map->shared) {
+        map_detach(map);
+    }
+
+    if (MAP_MODE(map, image)) {
+        map_unpack(map);
+    }
+    else if (MAP_MODE(map, pilots)) {
+        map_thaw(map);
+    }
+
+    if (map->size + count > mod || MAP_MODE(map, rehash) || MAP_SMALL(map)) {
+        mod += !mod * UTOPIA_HASH_SIZE;
+        while (mod < map->size + count) {
+            mod *= 2;
+        }
+        map_resize(map, mod);
+    }
+
+    threads = nthreads + !nthreads;
+    threads = threads < count ? threads : count;
+    builds = malloc(threads * sizeof(struct mapbuild));
+    builds->map = map;
+    builds->keys = keys;
+    builds->values = values;
+    builds->counts = calloc(threads * threads, sizeof(size_t));
+    builds->order = malloc(count * sizeof(size_t));
+    builds->base = map->size;
+    builds->count = count;
+    builds->threads = threads;
+    for (i = 0; i < threads; ++i) {
+        builds[i] = builds[0];
+        builds[i].thread = i;
+    }
+
+    map_build_run(builds, &map_build_hash);
+    for (sum = 0, j = 0; j < threads; ++j) {
+        for (i = 0; i < threads; ++i) {
+            const size_t n = builds->counts[i * threads + j];
+            builds->counts[i * threads + j] = sum;
+            sum += n;
+        }
+    }
+
+    map_build_run(builds, &map_build_scatter);
+    map_build_run(builds, &map_build_buckets);
+    for (i = 0; MAP_MODE(map, filter) && i < count; ++i) {
+        filter_add(map->mode->filter, map->hashes[map->size + i]);
+    }
+    map->size += count;
+
+    free(builds->counts);
+    free(builds->order);
+    free(builds);
+}
+
+size_t map_push_if(struct map* map, const void* key, const void* value)
+{
+    const size_t hash = MAP_HASH(map, key);
+    const size_t index = map->mod ? map_find(map, key, hash, &map_key_equal) : 0;
+    if (index) {
+        return index;
+    }
+
+    map_push_hash(map, key, value, hash);
+    return 0;
+}
+
+static void* map_upsert_hash(struct map* map, const void* key, const void* value, const size_t hash,
+                             void (*combine)(void*, const void*, void*), void* ctx)
+{
+    const size_t index = map->mod ? map_find(map, key, hash, &map_key_equal) : 0;
+    if (index) {
+        void* ptr = map_value_mut(map, index - 1);
+        if (combine) {
+            combine(ptr, value, ctx);
+        }
+        else memcpy(ptr, value, map->value_bytes);
+        return ptr;
+    }
+
+    return map_push_hash(map, key, value, hash);
+}
+
+void* map_upsert(struct map* map, const void* key, const void* value,
+                 void (*combine)(void*, const void*, void*), void* ctx)
+{
+    return map_upsert_hash(map, key, value, MAP_HASH(map, key), combine, ctx);
+}
+
+void map_upsert_batch(struct map* map, const void* keys, const void* values, const size_t count,
+                      void (*combine)(void*, const void*, void*), void* ctx)
+{
+    size_t i, j, n;
+    size_t hashes[UTOPIA_MAP_BATCH];
+    const char* key = keys, *value = values;
+
+    for (i = 0; i < count; i += n) {
+        n = count - i < UTOPIA_MAP_BATCH ? count - i : UTOPIA_MAP_BATCH;
+        
+        for (j = 0; j < n; ++j) {
+            hashes[j] = MAP_HASH(map, key + j * map->key_bytes);
+            map_prefetch(map, hashes[j]);
+        }
+
+        for (j = 0; j < n; ++j) {
+            map_upsert_hash(map, key, value, hashes[j], combine, ctx);
+            key += map->key_bytes;
+            value += map->value_bytes;
+        }
+    }
+}
+
+void* map_arena_push(struct map* map, const void* key, const size_t key_len,
+                     const void* value, const size_t value_len)
+{
+    size_t index;
+    struct mapslice k, v;
+    struct mapprobe probe;
+    const size_t hash = map_arena_hash(map, key, key_len);
+    const size_t bytes = MAP_ARENA_ALIGN(key_len) + MAP_ARENA_ALIGN(value_len) + sizeof(size_t);
+    
+    if (map->shared) {
+        map_detach(map);
+    }
+
+    if (MAP_MODE(map, image)) {
+        map_unpack(map);
+    }
+
+    probe.data = key;
+    probe.length = key_len;
+    index = map->mod ? map_find(map, &probe, hash, &map_arena_equal) : 0;
+    
+    if (!MAP_MODE(map, arena) || map->mode->arena_size + bytes > map->mode->arena_cap) {
+        map_arena_reserve(map, bytes);
+    }
+
+    v.length = value_len;
+    v.offset = map_arena_copy(map->mode->arena, &map->mode->arena_size, value, value_len);
+    if (index) {
+        ((struct mapslice*)map->values)[index - 1] = v;
+    }
+    else {
+        k.length = key_len;
+        k.offset = map_arena_copy(map->mode->arena, &map->mode->arena_size, key, key_len);
+        map_push_hash(map, &k, &v, hash);
+    }
+    
+    return map->mode->arena + v.offset;
+}
+
+size_t map_arena_search(const struct map* map, const void* key, const size_t key_len)
+{
+    struct mapprobe probe;
+    probe.data = key;
+    probe.length = key_len;
+    return map->mod ? map_find(map, &probe, map_arena_hash(map, key, key_len), &map_arena_equal) : 0;
+}
+
+int map_arena_remove(struct map* map, const void* key, const size_t key_len)
+{
+    struct mapprobe probe;
+    if (map->shared) {
+        map_detach(map);
+    }
+
+    if (MAP_MODE(map, image)) {
+        map_unpack(map);
+    }
+    else if (MAP_MODE(map, pilots)) {
+        map_thaw(map);
+    }
+
+    probe.data = key;
+    probe.length = key_len;
+    return map->mod ? map_erase(map, &probe, map_arena_hash(map, key, key_len), &map_arena_equal) : 0;
+}
+
+void* map_arena_key(const struct map* map, const size_t index, size_t* length)
+{
+    const struct mapslice* slice = (const struct mapslice*)map->keys + index;
+    if (length) {
+        *length = slice->length;
+    }
+    return map->mode->arena + slice->offset;
+}
+
+void* map_arena_value(const struct map* map, const size_t index, size_t* length)
+{
+    const struct mapslice* slice = (const struct mapslice*)map->values + index;
+    if (length) {
+        *length = slice->length;
+    }
+    return map->mode->arena + slice->offset;
+}
+
+void map_free(struct map* map)
+{
+    if (map->shared) {
+        size_t* shared = map->shared;
+        map->shared = NULL;
+        if (MAP_SHARED_RELEASE(shared)) {
+            struct map m = map_create(map->key_bytes, map->value_bytes);
+            m.compact = map->compact;
+            m.seed = map->seed;
+            m.func = map->func;
+            m.seeded = map->seeded;
+            m.eq = map->eq;
+            *map = m;
+            return;
+        }
+        free(shared);
+    }
+
+    if (MAP_MODE(map, image)) {
+        map_image_close(map->mode->image, map->mode->image_bytes);
+    }
+    else {
+        if (MAP_MODE(map, rehash)) {
+            buckets_free(map->mode->rehash, map->mode->rehash_mod);
+            free(map->mode->rehash);
+        }
+
+        if (map->indices) {
+            buckets_free(map->indices, map->mod);
+        }
+        free(map->indices);
+        free(map->hashes);
+        free(map->keys);
+        free(map->values);
+        if (map->mode) {
+            free(map->mode->links);
+            free(map->mode->pilots);
+            free(map->mode->arena);
+        }
+    }
+
+    if (map->mode) {
+        free(map->mode->filter);
+        free(map->mode);
+    }
+
+    map->indices = NULL;
+    map->hashes = NULL;
+    map->keys = NULL;
+    map->values = NULL;
+    map->mode = NULL;
+    map->size = 0;
+    map->mod = 0;
 }
 
 #endif /* UTOPIA_MAP_IMPLEMENTATED */
@@ -0,0 +1,574 @@
+
+/*  Copyright (c) 2022 Eugenio Arteaga A.
+
+Permission is hereby granted, free of charge, to any 
+person obtaining a copy of this software and associated 
+documentation files (the "Software"), to deal in the 
+Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to 
+permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice 
+shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+#ifndef UTOPIA_MULTIMAP_H
+#define UTOPIA_MULTIMAP_H
+
+/*=======================================================
+**************  UTOPIA UTILITY LIBRARY   ****************
+Simple and easy generic containers & data structures in C 
+================================== @Eugenio Arteaga A. */
+
+/***********************************
+Generic <Key, Values> Hash Multimap
+***********************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef USTDDEF_H
+#define USTDDEF_H <stddef.h>
+#endif
+
+#include USTDDEF_H
+
+struct multimaprun {
+    size_t offset;
+    size_t count;
+    size_t cap;
+};
+
+struct multimap {
+    size_t** indices;
+    size_t* hashes;
+    void* keys;
+    struct multimaprun* runs;
+    void* values;
+    size_t key_bytes;
+    size_t value_bytes;
+    size_t size;
+    size_t mod;
+    size_t count;
+    size_t used;
+    size_t cap;
+    size_t (*func)(const void*);
+    int (*eq)(const void*, const void*);
+};
+
+#define _multimap_key_at(mm, i) ((char*)(mm)->keys + (mm)->key_bytes * (i))
+#define _multimap_value_at(mm, i) ((char*)(mm)->values + (mm)->value_bytes * (i))
+
+struct multimap multimap_create(const size_t key_size, const size_t value_size);
+struct multimap multimap_copy(const struct multimap* multimap);
+size_t multimap_search(const struct multimap* multimap, const void* key);
+/* overloading the hash replaces the default strcmp equality with a memcmp of
+the key bytes, set multimap_overload_eq (e.g. equal_string) for char* keys */
+void multimap_overload(struct multimap* multimap, size_t (*hash_func)(const void*));
+void multimap_overload_eq(struct multimap* multimap, int (*eq_func)(const void*, const void*));
+void* multimap_key_at(const struct multimap* multimap, const size_t index);
+void* multimap_values_at(const struct multimap* multimap, const size_t index, size_t* count);
+void* multimap_values(const struct multimap* multimap, const void* key, size_t* count);
+size_t multimap_size(const struct multimap* multimap);
+size_t multimap_count(const struct multimap* multimap);
+size_t multimap_capacity(const struct multimap* multimap);
+size_t multimap_key_bytes(const struct multimap* multimap);
+size_t multimap_value_bytes(const struct multimap* multimap);
+void multimap_resize(struct multimap* multimap, const size_t size);
+void* multimap_push(struct multimap* multimap, const void* key, const void* value);
+int multimap_remove(struct multimap* multimap, const void* key);
+int multimap_remove_value(struct multimap* multimap, const void* key, const size_t index);
+void multimap_compact(struct multimap* multimap);
+void multimap_free(struct multimap* multimap);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* UTOPIA_MULTIMAP_H */
+
+#ifdef UTOPIA_IMPLEMENTATION
+
+#ifndef UTOPIA_MULTIMAP_IMPLEMENTED
+#define UTOPIA_MULTIMAP_IMPLEMENTED
+
+#ifndef USTDLIB_H 
+#define USTDLIB_H <stdlib.h>
+#endif
+
+#ifndef USTRING_H 
+#define USTRING_H <string.h>
+#endif
+
+#include USTDLIB_H
+#include USTRING_H
+
+/* Bucket Implementation */
+
+#ifndef UTOPIA_BUCKET_IMPLEMENTED
+#define UTOPIA_BUCKET_IMPLEMENTED
+
+#define BUCKET_CAP_INDEX 0
+#define BUCKET_SIZE_INDEX 1
+#define BUCKET_DATA_INDEX 2
+
+#define BUCKET_SIZE(bucket) (bucket ? bucket[BUCKET_SIZE_INDEX] : 0)
+#define BUCKET_CAP(bucket) (bucket ? bucket[BUCKET_CAP_INDEX] : 0)
+#define BUCKET_DATA(bucket) (bucket ? bucket[BUCKET_DATA_INDEX] : 0)
+
+static size_t* bucket_push(size_t* bucket, size_t index)
+{
+    size_t size = BUCKET_SIZE(bucket);
+    size_t cap = BUCKET_CAP(bucket);
+
+    if (size >= cap) {
+        cap = (!cap + cap) * 2;
+        bucket = realloc(bucket, (cap + BUCKET_DATA_INDEX) * sizeof(size_t));
+        bucket[BUCKET_CAP_INDEX] = cap;
+    }
+
+    bucket[BUCKET_DATA_INDEX + size] = index;
+    bucket[BUCKET_SIZE_INDEX] = size + 1;
+
+    return bucket;
+}
+
+static void bucket_remove(size_t** bucketref, const size_t index)
+{
+    size_t* bucket = *bucketref;
+    const size_t size = BUCKET_SIZE(bucket) + BUCKET_DATA_INDEX;
+    size_t* ptr = bucket + index;
+    memmove(ptr, ptr + 1, (size - index - 1) * sizeof(size_t));
+    bucket[BUCKET_SIZE_INDEX] = size - 1 - BUCKET_DATA_INDEX;
+    if (bucket[BUCKET_SIZE_INDEX] == 0) {
+        free(bucket);
+        *bucketref = NULL;
+    }
+}
+
+#endif /* UTOPIA_BUCKET_IMPLEMENTED */
+
+/* Bucket Array Implementation */
+
+#ifndef UTOPIA_BUCKET_ARRAY_IMPLEMENTED
+#define UTOPIA_BUCKET_ARRAY_IMPLEMENTED
+
+static void buckets_reindex(size_t** buckets, const size_t size, const size_t removed)
+{
+    size_t i, j;
+    for (i = 0; i < size; ++i) {
+        if (buckets[i]) {
+            const size_t count = BUCKET_SIZE(buckets[i]) + BUCKET_DATA_INDEX;
+            for (j = BUCKET_DATA_INDEX; j < count; j++) {
+                buckets[i][j] -= (buckets[i][j] >= removed);
+            }
+        }
+    }
+}
+
+static void buckets_free(size_t** buckets, const size_t size)
+{
+    size_t i;
+    for (i = 0; i < size; ++i) {
+        if (buckets[i]) {
+            free(buckets[i]);
+        }
+    }
+}
+
+#endif /* UTOPIA_BUCKET_ARRAY_IMPLEMENTED */
+
+/* Hashable Implementation */
+
+#ifndef UTOPIA_HASHABLE_IMPLEMENTED
+#define UTOPIA_HASHABLE_IMPLEMENTED
+
+#ifndef UTOPIA_HASH_SIZE
+#define UTOPIA_HASH_SIZE 32
+#endif
+
+static void* memdup(const void* src, size_t size)
+{
+    void* dup = malloc(size);
+    memcpy(dup, src, size);
+    return dup;
+}
+
+static size_t hash_default(const void* key)
+{
+#ifndef UTOPIA_HASH_UINT
+    int c;
+    size_t hash = 5381;
+    const unsigned char* str = *(unsigned char**)key;
+    while ((c = *str++)) {
+        hash = ((hash << 5) + hash) + c;
+    }
+    return hash;
+#else
+    size_t x = *(size_t*)key;
+    x = ((x >> 16) ^ x) * 0x45d9f3b;
+    x = ((x >> 16) ^ x) * 0x45d9f3b;
+    return (x >> 16) ^ x;
+#endif
+}
+
+#endif /* UTOPIA_HASHABLE_IMPLEMENTED */
+
+/* Equality Implementation */
+
+#ifndef UTOPIA_EQUALS_IMPLEMENTED
+#define UTOPIA_EQUALS_IMPLEMENTED
+
+static int equal_default(const void* a, const void* b)
+{
+#ifndef UTOPIA_HASH_UINT
+    return !strcmp(*(char**)a, *(char**)b);
+#else
+    return *(size_t*)a == *(size_t*)b;
+#endif
+}
+
+#endif /* UTOPIA_EQUALS_IMPLEMENTED */
+
+/***********************************
+Generic <Key, Values> Hash Multimap
+***********************************/
+
+static int multimap_key_equal(const struct multimap* multimap, const void* a, const void* b)
+{
+    return multimap->eq ? multimap->eq(a, b) : !memcmp(a, b, multimap->key_bytes);
+}
+
+static size_t multimap_bucket_search(const struct multimap* multimap, const size_t* bucket,
+                                     const void* key, const size_t hash)
+{
+    size_t i;
+    const size_t size = BUCKET_SIZE(bucket) + BUCKET_DATA_INDEX;
+    for (i = BUCKET_DATA_INDEX; i < size; ++i) {
+        const size_t find = bucket[i];
+        if (multimap->hashes[find] == hash && 
+            multimap_key_equal(multimap, _multimap_key_at(multimap, find), key)) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+static void multimap_pack(struct multimap* multimap, const size_t cap, const int tight)
+{
+    size_t i, used = 0;
+    const size_t bytes = multimap->value_bytes;
+    char* values = malloc(cap * bytes);
+    for (i = 0; i < multimap->size; ++i) {
+        struct multimaprun* run = multimap->runs + i;
+        if (run->count) {
+            memcpy(values + used * bytes, _multimap_value_at(multimap, run->offset), run->count * bytes);
+        }
+        run->offset = used;
+        run->cap = tight ? run->count : run->cap;
+        used += run->cap;
+    }
+
+    free(multimap->values);
+    multimap->values = values;
+    multimap->used = used;
+    multimap->cap = cap;
+}
+
+static void multimap_reserve(struct multimap* multimap, const size_t count)
+{
+    size_t i, live = count, cap = multimap->cap + !multimap->cap * UTOPIA_HASH_SIZE;
+    if (multimap->used + count <= multimap->cap) {
+        return;
+    }
+
+    for (i = 0; i < multimap->size; ++i) {
+        live += multimap->runs[i].cap;
+    }
+
+    while (cap < 2 * live) {
+        cap *= 2;
+    }
+
+    multimap_pack(multimap, cap, 0);
+}
+
+struct multimap multimap_create(const size_t key_size, const size_t value_size)
+{
+    struct multimap multimap;
+    multimap.indices = NULL;
+    multimap.hashes = NULL;
+    multimap.keys = NULL;
+    multimap.runs = NULL;
+    multimap.values = NULL;
+    multimap.key_bytes = key_size + !key_size;
+    multimap.value_bytes = value_size + !value_size;
+    multimap.size = 0;
+    multimap.mod = 0;
+    multimap.count = 0;
+    multimap.used = 0;
+    multimap.cap = 0;
+    multimap.func = &hash_default;
+    multimap.eq = &equal_default;
+    return multimap;
+}
+
+struct multimap multimap_copy(const struct multimap* multimap)
+{
+    struct multimap m = *multimap;
+    if (multimap->mod) {
+        size_t i, count;
+        m.hashes = memdup(multimap->hashes, multimap->mod * sizeof(size_t));
+        m.keys = memdup(multimap->keys, multimap->mod * multimap->key_bytes);
+        m.runs = memdup(multimap->runs, multimap->mod * sizeof(struct multimaprun));
+        m.indices = memdup(multimap->indices, multimap->mod * sizeof(size_t*));
+        for (i = 0; i < multimap->mod; ++i) {
+            count = BUCKET_SIZE(multimap->indices[i]);
+            if (count) {
+                m.indices[i] = memdup(multimap->indices[i], (count + BUCKET_DATA_INDEX) * sizeof(size_t));
+                m.indices[i][BUCKET_CAP_INDEX] = count;
+            }
+        }
+    }
+
+    if (multimap->cap) {
+        m.values = memdup(multimap->values, multimap->cap * multimap->value_bytes);
+    }
+    return m;
+}
+
+size_t multimap_search(const struct multimap* multimap, const void* key)
+{
+    if (multimap->mod) {
+        const size_t hash = multimap->func(key);
+        const size_t* bucket = multimap->indices[hash % multimap->mod];
+        const size_t search = multimap_bucket_search(multimap, bucket, key, hash);
+        if (search) {
+            return bucket[search] + 1;
+        }
+    }
+
+    return 0;
+}
+
+void multimap_overload(struct multimap* multimap, size_t (*func)(const void*))
+{
+    multimap->func = func;
+    if (multimap->eq == &equal_default) {
+        multimap->eq = NULL;
+    }
+}
+
+void multimap_overload_eq(struct multimap* multimap, int (*eq)(const void*, const void*))
+{
+    multimap->eq = eq;
+}
+
+void* multimap_key_at(const struct multimap* multimap, const size_t index)
+{
+    return _multimap_key_at(multimap, index);
+}
+
+void* multimap_values_at(const struct multimap* multimap, const size_t index, size_t* count)
+{
+    const struct multimaprun* run = multimap->runs + index;
+    if (count) {
+        *count = run->count;
+    }
+    return _multimap_value_at(multimap, run->offset);
+}
+
+void* multimap_values(const struct multimap* multimap, const void* key, size_t* count)
+{
+    const size_t index = multimap_search(multimap, key);
+    if (index) {
+        return multimap_values_at(multimap, index - 1, count);
+    }
+
+    if (count) {
+        *count = 0;
+    }
+    return NULL;
+}
+
+size_t multimap_size(const struct multimap* multimap)
+{
+    return multimap->size;
+}
+
+size_t multimap_count(const struct multimap* multimap)
+{
+    return multimap->count;
+}
+
+size_t multimap_capacity(const struct multimap* multimap)
+{
+    return multimap->mod;
+}
+
+size_t multimap_key_bytes(const struct multimap* multimap)
+{
+    return multimap->key_bytes;
+}
+
+size_t multimap_value_bytes(const struct multimap* multimap)
+{
+    return multimap->value_bytes;
+}
+
+void multimap_resize(struct multimap* multimap, const size_t new_size)
+{
+    size_t i;
+    const size_t size = multimap->size;
+
+    if (multimap->mod) {
+        buckets_free(multimap->indices, multimap->mod);
+    }
+
+    multimap->mod = new_size + !new_size * UTOPIA_HASH_SIZE;
+    multimap->hashes = realloc(multimap->hashes, multimap->mod * sizeof(size_t));
+    multimap->keys = realloc(multimap->keys, multimap->mod * multimap->key_bytes);
+    multimap->runs = realloc(multimap->runs, multimap->mod * sizeof(struct multimaprun));
+    multimap->indices = realloc(multimap->indices, multimap->mod * sizeof(size_t*));
+    memset(multimap->indices, 0, multimap->mod * sizeof(size_t*));
+    
+    for (i = 0; i < size; ++i) {
+        const size_t hash_mod = multimap->hashes[i] % multimap->mod;
+        multimap->indices[hash_mod] = bucket_push(multimap->indices[hash_mod], i);
+    }
+}
+
+void* multimap_push(struct multimap* multimap, const void* key, const void* value)
+{
+    void* ptr;
+    size_t index, hashmod;
+    struct multimaprun* run;
+    const size_t hash = multimap->func(key);
+    const size_t search = multimap->mod ? 
+        multimap_bucket_search(multimap, multimap->indices[hash % multimap->mod], key, hash) : 0;
+
+    if (search) {
+        index = multimap->indices[hash % multimap->mod][search];
+    }
+    else {
+        if (multimap->size == multimap->mod) {
+            multimap_resize(multimap, multimap->mod * 2);
+        }
+
+        index = multimap->size++;
+        hashmod = hash % multimap->mod;
+        multimap->indices[hashmod] = bucket_push(multimap->indices[hashmod], index);
+        multimap->hashes[index] = hash;
+        memcpy(_multimap_key_at(multimap, index), key, multimap->key_bytes);
+        multimap->runs[index].offset = multimap->used;
+        multimap->runs[index].count = 0;
+        multimap->runs[index].cap = 0;
+    }
+
+    run = multimap->runs + index;
+    if (run->count == run->cap) {
+        const size_t cap = (!run->cap + run->cap) * 2;
+        multimap_reserve(multimap, cap);
+        if (run->offset + run->cap == multimap->used) {
+            multimap->used += cap - run->cap;
+        }
+        else {
+            memcpy(_multimap_value_at(multimap, multimap->used), 
+                   _multimap_value_at(multimap, run->offset), run->count * multimap->value_bytes);
+            run->offset = multimap->used;
+            multimap->used += cap;
+        }
+        run->cap = cap;
+    }
+
+    ptr = _multimap_value_at(multimap, run->offset + run->count++);
+    memcpy(ptr, value, multimap->value_bytes);
+    ++multimap->count;
+    return ptr;
+}
+
+int multimap_remove(struct multimap* multimap, const void* key)
+{
+    if (multimap->mod) {
+        const size_t hash = multimap->func(key);
+        size_t** bucketref = multimap->indices + hash % multimap->mod;
+        const size_t search = multimap_bucket_search(multimap, *bucketref, key, hash);
+        if (search) {
+            const size_t find = (*bucketref)[search];
+            const size_t count = multimap->size - find - 1;
+            char* k = _multimap_key_at(multimap, find);
+            
+            multimap->count -= multimap->runs[find].count;
+            memmove(k, k + multimap->key_bytes, count * multimap->key_bytes);
+            memmove(multimap->hashes + find, multimap->hashes + find + 1, count * sizeof(size_t));
+            memmove(multimap->runs + find, multimap->runs + find + 1, count * sizeof(struct multimaprun));
+            
+            bucket_remove(bucketref, search);
+            buckets_reindex(multimap->indices, multimap->mod, find);
+            --multimap->size;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int multimap_remove_value(struct multimap* multimap, const void* key, const size_t index)
+{
+    const size_t find = multimap_search(multimap, key);
+    if (find && index < multimap->runs[find - 1].count) {
+        struct multimaprun* run = multimap->runs + find - 1;
+        char* ptr = _multimap_value_at(multimap, run->offset + index);
+        memmove(ptr, ptr + multimap->value_bytes, (--run->count - index) * multimap->value_bytes);
+        --multimap->count;
+        return 1;
+    }
+
+    return 0;
+}
+
+void multimap_compact(struct multimap* multimap)
+{
+    if (multimap->cap) {
+        multimap_pack(multimap, multimap->count + !multimap->count, 1);
+    }
+}
+
+void multimap_free(struct multimap* multimap)
+{
+    if (multimap->indices) {
+        buckets_free(multimap->indices, multimap->mod);
+        free(multimap->indices);
+        free(multimap->hashes);
+        free(multimap->keys);
+        free(multimap->runs);
+        multimap->indices = NULL;
+        multimap->hashes = NULL;
+        multimap->keys = NULL;
+        multimap->runs = NULL;
+        multimap->size = 0;
+        multimap->mod = 0;
+    }
+
+    if (multimap->values) {
+        free(multimap->values);
+        multimap->values = NULL;
+        multimap->count = 0;
+        multimap->used = 0;
+        multimap->cap = 0;
+    }
+}
+
+#endif /* UTOPIA_MULTIMAP_IMPLEMENTED */
+#endif /* UTOPIA_IMPLEMENTATION */
@@ -45,29 +45,74 @@ extern "C" {
 
 #include USTDDEF_H
 
+struct setmode {
+    unsigned int* links;
+    size_t* filter;
+    size_t resizes;
+    size_t probes;
+    size_t hash_calls;
+};
+
 struct set {
     size_t** indices;
+    size_t* hashes;
+    size_t* shared;
+    struct setmode* mode;
     void* data;
     size_t bytes;
     size_t size;
     size_t mod;
+    int compact;
+    size_t seed;
     size_t (*func)(const void*);
+    size_t (*seeded)(const void*, size_t, size_t);
+};
+
+#ifndef UTOPIA_STATS_BINS
+#define UTOPIA_STATS_BINS 8
+#endif
+
+struct set_stats {
+    size_t size;
+    size_t capacity;
+    size_t resizes;
+    size_t bytes;
+    size_t longest_chain;
+    size_t histogram[UTOPIA_STATS_BINS];
+    double load_factor;
+    double hit_probes;
+    double miss_probes;
+    size_t probes;
+    size_t hash_calls;
 };
 
 #define _set_index(set, i) ((char*)(set)->data + (i) * (set)->bytes)
 
 struct set set_create(const size_t bytes);
 struct set set_reserve(const size_t bytes, const size_t reserve);
+struct set set_create_compact(const size_t bytes);
 struct set set_copy(const struct set* set);
+/* set_snapshot is O(1) and shares the whole table, the first write through
+either side copies it once (copy-on-write per table, not per chunk) */
+struct set set_snapshot(struct set* set);
 size_t set_search(const struct set* set, const void* data);
 void set_overload(struct set* hash, size_t (*func)(const void*));
+void set_overload_seeded(struct set* set, size_t (*func)(const void*, size_t, size_t), size_t seed);
+void set_filter(struct set* set, const double rate);
+/* set_index aliases storage shared with snapshots, elements are hashed in place
+and must not be written through it */
 void* set_index(const struct set* set, const size_t index);
 size_t set_size(const struct set* set);
 size_t set_capacity(const struct set* set);
 size_t set_bytes(const struct set* set);
+struct set_stats set_stats(const struct set* set);
 void set_resize(struct set* set, const size_t new_size);
 void* set_push(struct set* set, const void* data);
 size_t set_push_if(struct set* set, const void* data);
+struct set set_union(const struct set* a, const struct set* b, const size_t nthreads);
+struct set set_intersect(const struct set* a, const struct set* b, const size_t nthreads);
+struct set set_difference(const struct set* a, const struct set* b, const size_t nthreads);
+struct set set_symmetric_difference(const struct set* a, const struct set* b, const size_t nthreads);
 int set_remove(struct set* set, const void* data);
 void set_free(struct set* set);
 
@@ -92,6 +137,47 @@ void set_free(struct set* set);
 #include USTDLIB_H
 #include USTRING_H
 
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(UTOPIA_NO_THREADS)
+#define UTOPIA_SET_THREADS
+#include <pthread.h>
+#endif
+
+#if defined(__SSE2__) && !defined(UTOPIA_NO_SIMD)
+#define UTOPIA_SET_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifndef UTOPIA_SET_GRAIN
+#define UTOPIA_SET_GRAIN 16384
+#endif
+
+#ifndef UTOPIA_SET_SMALL
+#define UTOPIA_SET_SMALL 16
+#endif
+
+#if UTOPIA_SET_SMALL > 32
+#error "UTOPIA_SET_SMALL must not exceed 32"
+#endif
+
+#ifdef __GNUC__
+#define SET_SHARED_ACQUIRE(shared) __atomic_add_fetch(shared, 1, __ATOMIC_ACQ_REL)
+#define SET_SHARED_RELEASE(shared) __atomic_sub_fetch(shared, 1, __ATOMIC_ACQ_REL)
+#define SET_SHARED_LOAD(shared) __atomic_load_n(shared, __ATOMIC_ACQUIRE)
+#else
+#define SET_SHARED_ACQUIRE(shared) (++*(shared))
+#define SET_SHARED_RELEASE(shared) (--*(shared))
+#define SET_SHARED_LOAD(shared) (*(shared))
+#endif
+
+#define SET_HASH(set, data) \
+    ((set)->seeded ? (set)->seeded((data), (set)->bytes, (set)->seed) : (set)->func(data))
+
+#ifdef UTOPIA_STATS
+#define SET_STATS_COUNT(set, field) ((set)->mode ? (void)++(set)->mode->field : (void)0)
+#else
+#define SET_STATS_COUNT(set, field) ((void)0)
+#endif
+
 /* Bucket Implementation */
 
 #ifndef UTOPIA_BUCKET_IMPLEMENTED
@@ -183,7 +269,7 @@ static void* memdup(const void* src, size_t size)
     return dup;
 }
 
-static size_t set_default(const void* key)
+static size_t hash_default(const void* key)
 {
 #ifndef UTOPIA_HASH_UINT
     int c;
@@ -203,19 +289,333 @@ static size_t set_default(const void* key)
 
 #endif /* UTOPIA_HASHABLE_IMPLEMENTED */
 
+/* Filter Implementation */
+
+#ifndef UTOPIA_FILTER_IMPLEMENTED
+#define UTOPIA_FILTER_IMPLEMENTED
+
+#define FILTER_BLOOM 1
+#define FILTER_FUSE 2
+
+#define FILTER_KIND_INDEX 0
+#define FILTER_COUNT_INDEX 1
+#define FILTER_SEED_INDEX 2
+#define FILTER_BITS_INDEX 3
+#define FILTER_HEADER 4
+
+#define FILTER_BLOCK_BYTES 64
+#define FILTER_BLOCK_BITS 512
+#define FILTER_GOLDEN 0x9E3779B9
+
+#define FILTER_DATA(filter) ((unsigned char*)(((size_t)((filter) + FILTER_HEADER) + \
+                             FILTER_BLOCK_BYTES - 1) & ~(size_t)(FILTER_BLOCK_BYTES - 1)))
+#define FILTER_DATA_BYTES(filter) ((filter)[FILTER_KIND_INDEX] == FILTER_BLOOM ? \
+                                   (filter)[FILTER_COUNT_INDEX] * FILTER_BLOCK_BYTES : \
+                                   (filter)[FILTER_COUNT_INDEX] * 3)
+#define FILTER_BYTES(filter) (FILTER_HEADER * sizeof(size_t) + FILTER_BLOCK_BYTES + FILTER_DATA_BYTES(filter))
+
+#define FILTER_BLOOM_BLOCK(filter, hash) \
+    (FILTER_DATA(filter) + filter_mix(hash) % (filter)[FILTER_COUNT_INDEX] * FILTER_BLOCK_BYTES)
+#define FILTER_BLOOM_BIT(pos) (1 << ((pos) & 7))
+#define FILTER_BLOOM_BYTE(pos) (((pos) % FILTER_BLOCK_BITS) >> 3)
+
+#define FILTER_FUSE_SLOT(mix, i, count) ((i) * (count) + filter_mix((mix) + (size_t)(i) * FILTER_GOLDEN) % (count))
+#define FILTER_FUSE_PRINT(mix) ((unsigned char)((mix) >> 8))
+
+static size_t filter_mix(size_t x)
+{
+    x ^= x >> (sizeof(size_t) * 4);
+    x = ((x >> 16) ^ x) * 0x45d9f3b;
+    x = ((x >> 16) ^ x) * 0x45d9f3b;
+    return (x >> 16) ^ x;
+}
+
+static size_t filter_bits(const double rate)
+{
+    size_t bits = 0;
+    double p = 1.0;
+    while (p > rate && bits < 32) {
+        p *= 0.5;
+        ++bits;
+    }
+    return (bits * 3 + 1) / 2;
+}
+
+static size_t* filter_alloc(const size_t kind, const size_t count, const size_t seed, const size_t bits)
+{
+    size_t* filter, header[FILTER_HEADER];
+    header[FILTER_KIND_INDEX] = kind;
+    header[FILTER_COUNT_INDEX] = count;
+    header[FILTER_SEED_INDEX] = seed;
+    header[FILTER_BITS_INDEX] = bits;
+    filter = calloc(FILTER_BYTES(header), 1);
+    memcpy(filter, header, sizeof(header));
+    return filter;
+}
+
+static size_t* filter_copy(const size_t* filter)
+{
+    size_t* copy = filter_alloc(filter[FILTER_KIND_INDEX], filter[FILTER_COUNT_INDEX],
+                                filter[FILTER_SEED_INDEX], filter[FILTER_BITS_INDEX]);
+    memcpy(FILTER_DATA(copy), FILTER_DATA(filter), FILTER_DATA_BYTES(filter));
+    return copy;
+}
+
+static size_t* filter_bloom(size_t* filter, const size_t capacity, const size_t bits)
+{
+    size_t k = (bits * 7 + 5) / 10;
+    k = k < 1 ? 1 : k > 16 ? 16 : k;
+    free(filter);
+    return filter_alloc(FILTER_BLOOM, (capacity * bits + FILTER_BLOCK_BITS - 1) / FILTER_BLOCK_BITS + 1, k, bits);
+}
+
+static void filter_add(size_t* filter, const size_t hash)
+{
+    size_t i, pos = filter_mix(hash ^ FILTER_GOLDEN);
+    const size_t step = (pos >> 16) | 1;
+    unsigned char* block = FILTER_BLOOM_BLOCK(filter, hash);
+    for (i = 0; i < filter[FILTER_SEED_INDEX]; ++i, pos += step) {
+        block[FILTER_BLOOM_BYTE(pos)] |= (unsigned char)FILTER_BLOOM_BIT(pos);
+    }
+}
+
+static int filter_query(const size_t* filter, const size_t hash)
+{
+    size_t i, pos, step;
+    const unsigned char* data;
+    if (filter[FILTER_KIND_INDEX] == FILTER_FUSE) {
+        const size_t count = filter[FILTER_COUNT_INDEX];
+        const size_t mix = filter_mix(hash ^ filter[FILTER_SEED_INDEX]);
+        data = FILTER_DATA(filter);
+        return FILTER_FUSE_PRINT(mix) == (data[FILTER_FUSE_SLOT(mix, 0, count)] ^
+                                          data[FILTER_FUSE_SLOT(mix, 1, count)] ^ 
+                                          data[FILTER_FUSE_SLOT(mix, 2, count)]);
+    }
+
+    pos = filter_mix(hash ^ FILTER_GOLDEN);
+    step = (pos >> 16) | 1;
+    data = FILTER_BLOOM_BLOCK(filter, hash);
+    for (i = 0; i < filter[FILTER_SEED_INDEX]; ++i, pos += step) {
+        if (!(data[FILTER_BLOOM_BYTE(pos)] & FILTER_BLOOM_BIT(pos))) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+#endif /* UTOPIA_FILTER_IMPLEMENTED */
+
 /*****************
  Generic Hash Set
 *****************/
 
+#define SET_LINK_MAX 0xFFFFFFFF
+#define SET_LINK_NEXT(set, i) ((set)->mode->links + (set)->mod + (i))
+#define SET_MODE(set, field) ((set)->mode ? (set)->mode->field : 0)
+
+static struct setmode* set_mode(struct set* set)
+{
+    if (!set->mode) {
+        set->mode = calloc(1, sizeof(struct setmode));
+    }
+    return set->mode;
+}
+
+static unsigned int* set_link_search(const struct set* set, const size_t hash)
+{
+    unsigned int* link = set->mode->links + hash % set->mod;
+    while (*link) {
+        SET_STATS_COUNT(set, probes);
+        SET_STATS_COUNT(set, hash_calls);
+        if (hash == SET_HASH(set, _set_index(set, *link - 1))) {
+            return link;
+        }
+        link = SET_LINK_NEXT(set, *link - 1);
+    }
+    return NULL;
+}
+
+#define SET_SMALL_LANES (16 / sizeof(size_t))
+
+static unsigned long set_small_match(const size_t* hashes, const size_t size, const size_t hash)
+{
+    size_t i = 0;
+    unsigned long mask = 0;
+#ifdef UTOPIA_SET_SSE2
+    size_t lanes[SET_SMALL_LANES];
+    __m128i needle;
+    for (i = 0; i < SET_SMALL_LANES; ++i) {
+        lanes[i] = hash;
+    }
+    needle = _mm_loadu_si128((const __m128i*)lanes);
+    for (i = 0; i + SET_SMALL_LANES <= size; i += SET_SMALL_LANES) {
+        const __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(hashes + i)), needle);
+        unsigned long bits = (unsigned long)_mm_movemask_ps(_mm_castsi128_ps(eq));
+        if (SET_SMALL_LANES == 2) {
+            bits &= bits >> 1;
+            bits = (bits & 1) | ((bits >> 1) & 2);
+        }
+        mask |= bits << i;
+    }
+#endif
+    for (; i < size; ++i) {
+        mask |= (unsigned long)(hashes[i] == hash) << i;
+    }
+    return mask;
+}
+
+static size_t set_small_search(const struct set* set, const size_t hash)
+{
+    size_t i;
+    unsigned long mask = set_small_match(set->hashes, set->size, hash);
+    for (i = 0; mask; ++i, mask >>= 1) {
+        if (mask & 1) {
+            SET_STATS_COUNT(set, probes);
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+/* Set Algebra Implementation */
+
+#define SET_KEEP_SHARED 1
+#define SET_KEEP_UNIQUE 2
+
+struct setprobe {
+    const struct set* small;
+    const struct set* large;
+    char* small_found;
+    char* large_found;
+    size_t begin;
+    size_t end;
+};
+
+static void* set_probe_range(void* arg)
+{
+    size_t i, find;
+    struct setprobe* p = arg;
+    for (i = p->begin; i < p->end; ++i) {
+        find = set_search(p->large, _set_index(p->small, i));
+        if (find) {
+            p->small_found[i] = 1;
+            p->large_found[find - 1] = 1;
+        }
+    }
+    return NULL;
+}
+
+static void set_probe(struct setprobe* p, const size_t nthreads)
+{
+    size_t i, chunk, threads = nthreads + !nthreads;
+    const size_t limit = p->small->size / UTOPIA_SET_GRAIN + 1;
+    threads = threads < limit ? threads : limit;
+    chunk = (p->small->size + threads - 1) / threads;
+    p->begin = 0;
+    p->end = p->small->size;
+
+#ifdef UTOPIA_SET_THREADS
+    if (threads > 1) {
+        struct setprobe* probes = malloc(threads * sizeof(struct setprobe));
+        pthread_t* handles = malloc(threads * sizeof(pthread_t));
+        int* spawned = calloc(threads, sizeof(int));
+        for (i = 0; i < threads; ++i) {
+            probes[i] = *p;
+            probes[i].begin = i * chunk < p->end ? i * chunk : p->end;
+            probes[i].end = probes[i].begin + chunk < p->end ? probes[i].begin + chunk : p->end;
+        }
+
+        for (i = 1; i < threads; ++i) {
+            spawned[i] = !pthread_create(handles + i, NULL, set_probe_range, probes + i);
+            if (!spawned[i]) {
+                set_probe_range(probes + i);
+            }
+        }
+
+        set_probe_range(probes);
+        for (i = 1; i < threads; ++i) {
+            if (spawned[i]) {
+                pthread_join(handles[i], NULL);
+            }
+        }
+
+        free(spawned);
+        free(handles);
+        free(probes);
+        return;
+    }
+#else
+    (void)i;
+    (void)chunk;
+#endif
+    set_probe_range(p);
+}
+
+static size_t set_algebra_copy(char* dst, const struct set* set, const char* found, const int keep)
+{
+    size_t i, count = 0;
+    for (i = 0; i < set->size; ++i) {
+        if (keep & (found[i] ? SET_KEEP_SHARED : SET_KEEP_UNIQUE)) {
+            if (dst) {
+                memcpy(dst + count * set->bytes, _set_index(set, i), set->bytes);
+            }
+            ++count;
+        }
+    }
+    return count;
+}
+
+static struct set set_algebra(const struct set* a, const struct set* b, 
+                              const int keep_a, const int keep_b, const size_t nthreads)
+{
+    size_t count;
+    struct setprobe p;
+    struct set set = set_create(a->bytes);
+    char* found = calloc(a->size + b->size + 1, 1);
+    set.compact = a->compact;
+    set.seed = a->seed;
+    set.func = a->func;
+    set.seeded = a->seeded;
+
+    p.small = a->size <= b->size ? a : b;
+    p.large = a->size <= b->size ? b : a;
+    p.small_found = found + (p.small == a ? 0 : a->size);
+    p.large_found = found + (p.small == a ? a->size : 0);
+    if (a->mod && b->mod) {
+        set_probe(&p, nthreads);
+    }
+
+    count = set_algebra_copy(NULL, a, found, keep_a) + 
+            set_algebra_copy(NULL, b, found + a->size, keep_b);
+    if (count) {
+        set.data = malloc(count * set.bytes);
+        set.size = set_algebra_copy(set.data, a, found, keep_a);
+        set.size += set_algebra_copy((char*)set.data + set.size * set.bytes, b, found + a->size, keep_b);
+        if (SET_MODE(a, filter)) {
+            set_mode(&set)->filter = filter_alloc(FILTER_BLOOM, 1, 1, a->mode->filter[FILTER_BITS_INDEX]);
+        }
+        set_resize(&set, count);
+    }
+
+    free(found);
+    return set;
+}
+
 struct set set_create(const size_t bytes)
 {
     struct set set;
     set.indices = NULL;
+    set.hashes = NULL;
+    set.shared = NULL;
+    set.mode = NULL;
     set.data = NULL;
     set.bytes = bytes + !bytes;
     set.size = 0;
     set.mod = 0;
-    set.func = &set_default;
+    set.compact = 0;
+    set.seed = 0;
+    set.func = &hash_default;
+    set.seeded = NULL;
     return set;
 }
 
@@ -224,17 +624,43 @@ struct set set_reserve(const size_t bytes, const size_t reserve)
     struct set set;
     set.bytes = bytes + !bytes;
     set.indices = reserve ? calloc(reserve, sizeof(size_t*)) : NULL;
+    set.hashes = NULL;
+    set.shared = NULL;
+    set.mode = NULL;
     set.data = reserve ? malloc(reserve * set.bytes) : NULL;
     set.mod = reserve;
     set.size = 0;
-    set.func = &set_default;
+    set.compact = 0;
+    set.seed = 0;
+    set.func = &hash_default;
+    set.seeded = NULL;
+    return set;
+}
+
+struct set set_create_compact(const size_t bytes)
+{
+    struct set set = set_create(bytes);
+    set.compact = 1;
     return set;
 }
 
 struct set set_copy(const struct set* set)
 {
     struct set t = *set;
-    if (set->mod) {
+    t.shared = NULL;
+    t.mode = set->mode ? memdup(set->mode, sizeof(struct setmode)) : NULL;
+    if (t.mode && t.mode->filter) {
+        t.mode->filter = filter_copy(t.mode->filter);
+    }
+    if (SET_MODE(set, links)) {
+        t.data = memdup(set->data, set->mod * set->bytes);
+        t.mode->links = memdup(set->mode->links, 2 * set->mod * sizeof(unsigned int));
+    }
+    else if (set->hashes) {
+        t.data = memdup(set->data, set->mod * set->bytes);
+        t.hashes = memdup(set->hashes, set->mod * sizeof(size_t));
+    }
+    else if (set->mod) {
         size_t i, size;
 
         t.data = memdup(set->data, set->mod * set->bytes);
@@ -245,12 +671,41 @@ struct set set_copy(const struct set* set)
             if (size) {
                 size += BUCKET_DATA_INDEX;
                 t.indices[i] = memdup(set->indices[i], size * sizeof(size_t));
+                t.indices[i][BUCKET_CAP_INDEX] = size - BUCKET_DATA_INDEX;
             }
         }
     }
     return t;
 }
 
+struct set set_snapshot(struct set* set)
+{
+    if (!set->shared) {
+        set->shared = malloc(sizeof(size_t));
+        *set->shared = 1;
+    }
+
+    SET_SHARED_ACQUIRE(set->shared);
+    return *set;
+}
+
+static void set_detach(struct set* set)
+{
+    size_t* shared = set->shared;
+    set->shared = NULL;
+    if (SET_SHARED_LOAD(shared) > 1) {
+        struct set t = set_copy(set);
+        if (SET_SHARED_RELEASE(shared)) {
+            *set = t;
+            return;
+        }
+
+        set_free(set);
+        *set = t;
+    }
+    free(shared);
+}
+
 size_t set_capacity(const struct set* set)
 {
     return set->mod;
@@ -259,6 +714,33 @@ size_t set_capacity(const struct set* set)
 void set_overload(struct set* hash, size_t (*func)(const void*))
 {
     hash->func = func;
+    hash->seeded = NULL;
+}
+
+void set_overload_seeded(struct set* set, size_t (*func)(const void*, size_t, size_t), size_t seed)
+{
+    set->seeded = func;
+    set->seed = seed;
+}
+
+void set_filter(struct set* set, const double rate)
+{
+    size_t i;
+    if (set->shared) {
+        set_detach(set);
+    }
+
+    if (set->mode) {
+        free(set->mode->filter);
+        set->mode->filter = NULL;
+    }
+    if (rate > 0.0 && rate < 1.0) {
+        struct setmode* mode = set_mode(set);
+        mode->filter = filter_bloom(NULL, set->mod, filter_bits(rate));
+        for (i = 0; i < set->size; ++i) {
+            filter_add(mode->filter, SET_HASH(set, _set_index(set, i)));
+        }
+    }
 }
 
 void* set_index(const struct set* set, const size_t index)
@@ -276,18 +758,103 @@ size_t set_bytes(const struct set* set)
     return set->bytes;
 }
 
+struct set_stats set_stats(const struct set* set)
+{
+    size_t i, count;
+    struct set_stats stats;
+    memset(&stats, 0, sizeof(stats));
+    stats.size = set->size;
+    stats.capacity = set->mod;
+    stats.resizes = SET_MODE(set, resizes);
+    stats.probes = SET_MODE(set, probes);
+    stats.hash_calls = SET_MODE(set, hash_calls);
+    stats.bytes = set->mod * (sizeof(size_t*) + set->bytes);
+    if (SET_MODE(set, links)) {
+        stats.bytes = set->mod * (2 * sizeof(unsigned int) + set->bytes);
+    }
+    else if (set->hashes) {
+        stats.bytes = set->mod * (sizeof(size_t) + set->bytes);
+    }
+
+    if (SET_MODE(set, filter)) {
+        stats.bytes += FILTER_BYTES(set->mode->filter);
+    }
+    if (set->mode) {
+        stats.bytes += sizeof(struct setmode);
+    }
+
+    for (i = 0; i < (set->hashes ? 1 : set->mod); ++i) {
+        if (set->hashes) {
+            count = set->size;
+        }
+        else if (SET_MODE(set, links)) {
+            const unsigned int* link = set->mode->links + i;
+            for (count = 0; *link; link = SET_LINK_NEXT(set, *link - 1)) {
+                ++count;
+            }
+        }
+        else {
+            count = BUCKET_SIZE(set->indices[i]);
+            if (count) {
+                stats.bytes += (BUCKET_CAP(set->indices[i]) + BUCKET_DATA_INDEX) * sizeof(size_t);
+            }
+        }
+
+        ++stats.histogram[count < UTOPIA_STATS_BINS ? count : UTOPIA_STATS_BINS - 1];
+        stats.longest_chain = count > stats.longest_chain ? count : stats.longest_chain;
+        stats.hit_probes += 0.5 * (double)count * (double)(count + 1);
+    }
+
+    if (set->mod) {
+        stats.load_factor = (double)set->size / (double)set->mod;
+        stats.miss_probes = stats.load_factor;
+    }
+
+    if (set->size) {
+        stats.hit_probes /= (double)set->size;
+    }
+
+    return stats;
+}
+
 size_t set_search(const struct set* set, const void* data)
 {
+    const struct setmode* mode = set->mode;
+    if (mode && mode->links) {
+        const unsigned int* link;
+        const size_t hash = SET_HASH(set, data);
+        SET_STATS_COUNT(set, hash_calls);
+        if (mode->filter && !filter_query(mode->filter, hash)) {
+            return 0;
+        }
+        link = set_link_search(set, hash);
+        return link ? *link : 0;
+    }
+
+    if (set->hashes) {
+        const size_t hash = SET_HASH(set, data);
+        SET_STATS_COUNT(set, hash_calls);
+        return set_small_search(set, hash);
+    }
+
     if (set->mod) {
     
         size_t i;
-        const size_t hash = set->func(data);
-        const size_t* bucket = set->indices[hash % set->mod];
+        const size_t hash = SET_HASH(set, data);
+        const size_t* bucket;
+        size_t size;
+        SET_STATS_COUNT(set, hash_calls);
+        if (mode && mode->filter && !filter_query(mode->filter, hash)) {
+            return 0;
+        }
     
-        const size_t size = BUCKET_SIZE(bucket) + BUCKET_DATA_INDEX;
+        bucket = set->indices[hash % set->mod];
+        size = BUCKET_SIZE(bucket) + BUCKET_DATA_INDEX;
         for (i = BUCKET_DATA_INDEX; i < size; ++i) {
             void* k = _set_index(set, bucket[i]);
-            if (hash == set->func(k)) {
+            SET_STATS_COUNT(set, probes);
+            SET_STATS_COUNT(set, hash_calls);
+            if (hash == SET_HASH(set, k)) {
                 return bucket[i] + 1;
             }
         }
@@ -303,34 +870,102 @@ void set_resize(struct set* set, const size_t new_size)
     const size_t size = set->size;
     const size_t bytes = set->bytes;
 
-    if (set->mod) {
+    if (set->shared) {
+        set_detach(set);
+    }
+
+    if (set->indices) {
         buckets_free(set->indices, set->mod);
     }
 
+    free(set->hashes);
+    set->hashes = NULL;
     set->mod = new_size + !new_size * UTOPIA_HASH_SIZE;
     set->data = realloc(set->data, set->mod * set->bytes);
+    ++set_mode(set)->resizes;
+    if (SET_MODE(set, filter)) {
+        set->mode->filter = filter_bloom(set->mode->filter, set->mod, set->mode->filter[FILTER_BITS_INDEX]);
+    }
+
+    if (set->compact && set->mod < SET_LINK_MAX) {
+        struct setmode* mode = set_mode(set);
+        mode->links = realloc(mode->links, 2 * set->mod * sizeof(unsigned int));
+        memset(mode->links, 0, set->mod * sizeof(unsigned int));
+        for (i = size; i; --i) {
+            const size_t hash = SET_HASH(set, _set_index(set, i - 1));
+            unsigned int* head = mode->links + hash % set->mod;
+            if (mode->filter) {
+                filter_add(mode->filter, hash);
+            }
+            *SET_LINK_NEXT(set, i - 1) = *head;
+            *head = (unsigned int)i;
+        }
+        return;
+    }
+
+    if (set->mode) {
+        free(set->mode->links);
+        set->mode->links = NULL;
+    }
+    set->compact = 0;
     set->indices = realloc(set->indices, set->mod * sizeof(size_t*));
     memset(set->indices, 0, set->mod * sizeof(size_t*));
     
     key = set->data;
     for (i = 0; i < size; ++i, key += bytes) {
-        const size_t set_mod = set->func(key) % set->mod;
+        const size_t hash = SET_HASH(set, key);
+        const size_t set_mod = hash % set->mod;
+        if (SET_MODE(set, filter)) {
+            filter_add(set->mode->filter, hash);
+        }
         set->indices[set_mod] = bucket_push(set->indices[set_mod], i);
     }
 }
 
 int set_remove(struct set* set, const void* data)
 {
-    if (set->mod) {
+    if (set->shared) {
+        set_detach(set);
+    }
+
+    if (SET_MODE(set, links)) {
+        unsigned int* link = set_link_search(set, SET_HASH(set, data));
+        if (link) {
+            size_t i;
+            const size_t find = *link - 1;
+            char* ptr = _set_index(set, find);
+            *link = *SET_LINK_NEXT(set, find);
+            memmove(ptr, ptr + set->bytes, (--set->size - find) * set->bytes);
+            memmove(SET_LINK_NEXT(set, find), SET_LINK_NEXT(set, find + 1), 
+                    (set->size - find) * sizeof(unsigned int));
+            for (i = 0; i < set->mod + set->size; ++i) {
+                set->mode->links[i] -= (set->mode->links[i] > find);
+            }
+            return 1;
+        }
+    }
+    else if (set->hashes) {
+        const size_t search = set_small_search(set, SET_HASH(set, data));
+        if (search) {
+            const size_t find = search - 1;
+            const size_t count = --set->size - find;
+            char* ptr = _set_index(set, find);
+            memmove(ptr, ptr + set->bytes, count * set->bytes);
+            memmove(set->hashes + find, set->hashes + find + 1, count * sizeof(size_t));
+            return 1;
+        }
+    }
+    else if (set->mod) {
 
         size_t i, search = 0;
-        const size_t hash = set->func(data);
-        size_t* bucket = set->indices[hash % set->mod];
+        const size_t hash = SET_HASH(set, data);
+        size_t** bucketref = set->indices + hash % set->mod;
+        size_t* bucket = *bucketref;
 
         const size_t size = BUCKET_SIZE(bucket) + BUCKET_DATA_INDEX;
         for (i = BUCKET_DATA_INDEX; i < size; ++i) {
             void* k = _set_index(set, bucket[i]);
-            if (hash == set->func(k)) {
+            if (hash == SET_HASH(set, k)) {
                 search = i;
                 break;
             }
@@ -340,7 +975,7 @@ int set_remove(struct set* set, const void* data)
             const size_t find = bucket[search];
             char* ptr = _set_index(set, find);
             memmove(ptr, ptr + set->bytes, (--set->size - find) * set->bytes);
-            bucket_remove(&bucket, search);
+            bucket_remove(bucketref, search);
             buckets_reindex(set->indices, set->mod, find);
             return 1;
         }
@@ -352,14 +987,41 @@ int set_remove(struct set* set, const void* data)
 void* set_push(struct set* set, const void* data)
 {
     void* ptr;
-    size_t hashmod;
+    size_t hash, hashmod;
+    if (set->shared) {
+        set_detach(set);
+    }
+
     if (set->size == set->mod) {
-        set_resize(set, set->mod * 2);
+        if (!set->mod && UTOPIA_SET_SMALL) {
+            set->mod = UTOPIA_SET_SMALL;
+            set->data = realloc(set->data, set->mod * set->bytes);
+            set->hashes = realloc(set->hashes, set->mod * sizeof(size_t));
+        }
+        else if (set->hashes) {
+            set_resize(set, UTOPIA_HASH_SIZE > set->mod * 2 ? UTOPIA_HASH_SIZE : set->mod * 2);
+        }
+        else set_resize(set, set->mod * 2);
     }
 
-    hashmod = set->func(data) % set->mod;
+    hash = SET_HASH(set, data);
+    hashmod = hash % set->mod;
+    if (SET_MODE(set, filter)) {
+        filter_add(set->mode->filter, hash);
+    }
     ptr = _set_index(set, set->size);
-    set->indices[hashmod] = bucket_push(set->indices[hashmod], set->size++);
+    if (SET_MODE(set, links)) {
+        unsigned int* link = set->mode->links + hashmod;
+        while (*link) {
+            link = SET_LINK_NEXT(set, *link - 1);
+        }
+        *SET_LINK_NEXT(set, set->size) = 0;
+        *link = (unsigned int)++set->size;
+    }
+    else if (set->indices) {
+        set->indices[hashmod] = bucket_push(set->indices[hashmod], set->size++);
+    }
+    else set->hashes[set->size++] = hash;
     memcpy(ptr, data, set->bytes);
     return ptr;
 }
@@ -375,18 +1037,64 @@ size_t set_push_if(struct set* set, const void* data)
     return 0;
 }
 
+struct set set_union(const struct set* a, const struct set* b, const size_t nthreads)
+{
+    return set_algebra(a, b, SET_KEEP_SHARED | SET_KEEP_UNIQUE, SET_KEEP_UNIQUE, nthreads);
+}
+
+struct set set_intersect(const struct set* a, const struct set* b, const size_t nthreads)
+{
+    return set_algebra(a, b, SET_KEEP_SHARED, 0, nthreads);
+}
+
+struct set set_difference(const struct set* a, const struct set* b, const size_t nthreads)
+{
+    return set_algebra(a, b, SET_KEEP_UNIQUE, 0, nthreads);
+}
+
+struct set set_symmetric_difference(const struct set* a, const struct set* b, const size_t nthreads)
+{
+    return set_algebra(a, b, SET_KEEP_UNIQUE, SET_KEEP_UNIQUE, nthreads);
+}
+
 void set_free(struct set* set)
 {
-    if (set->indices) {
-        buckets_free(set->indices, set->mod);
+    if (set->shared) {
+        size_t* shared = set->shared;
+        set->shared = NULL;
+        if (SET_SHARED_RELEASE(shared)) {
+            struct set t = set_create(set->bytes);
+            t.compact = set->compact;
+            t.seed = set->seed;
+            t.func = set->func;
+            t.seeded = set->seeded;
+            *set = t;
+            return;
+        }
+        free(shared);
+    }
+
+    if (set->indices || SET_MODE(set, links) || set->hashes) {
+        if (set->indices) {
+            buckets_free(set->indices, set->mod);
+        }
         free(set->indices);
+        free(set->hashes);
         free(set->data);
 
         set->indices = NULL;
+        set->hashes = NULL;
         set->data = NULL;
         set->size = 0;
         set->mod = 0;
     }
+
+    if (set->mode) {
+        free(set->mode->links);
+        free(set->mode->filter);
+        free(set->mode);
+        set->mode = NULL;
+    }
 }
 
 #endif /* UTOPIA_SET_IMPLEMENTED */
@@ -0,0 +1,445 @@
+
+/*  Copyright (c) 2022 Eugenio Arteaga A.
+
+Permission is hereby granted, free of charge, to any 
+person obtaining a copy of this software and associated 
+documentation files (the "Software"), to deal in the 
+Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to 
+permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice 
+shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+#ifndef UTOPIA_SSET_H
+#define UTOPIA_SSET_H
+
+/*=======================================================
+**************  UTOPIA UTILITY LIBRARY   ****************
+Simple and easy generic containers & data structures in C 
+================================== @Eugenio Arteaga A. */
+
+/***********************************
+Sharded Hash Set for Parallel Dedup
+***********************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef USTDDEF_H
+#define USTDDEF_H <stddef.h>
+#endif
+
+#include USTDDEF_H
+
+struct sshard {
+    size_t* slots;
+    size_t* hashes;
+    void* data;
+    size_t size;
+    size_t mod;
+    char pad[64 - 3 * sizeof(void*) - 2 * sizeof(size_t)];
+};
+
+struct sset {
+    struct sshard* shards;
+    size_t count;
+    size_t bytes;
+    size_t (*func)(const void*);
+};
+
+struct sset sset_create(const size_t bytes, const size_t shards);
+struct sset sset_copy(const struct sset* sset);
+void sset_overload(struct sset* sset, size_t (*func)(const void*));
+int sset_search(const struct sset* sset, const void* data);
+int sset_push(struct sset* sset, const void* data);
+size_t sset_push_batch(struct sset* sset, const void* data, const size_t count, 
+                       const size_t nthreads, char* inserted);
+size_t sset_size(const struct sset* sset);
+size_t sset_bytes(const struct sset* sset);
+size_t sset_to_array(const struct sset* sset, void* buffer);
+void sset_free(struct sset* sset);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* UTOPIA_SSET_H */
+
+#ifdef UTOPIA_IMPLEMENTATION
+
+#ifndef UTOPIA_SSET_IMPLEMENTED
+#define UTOPIA_SSET_IMPLEMENTED
+
+#ifndef USTDLIB_H 
+#define USTDLIB_H <stdlib.h>
+#endif
+
+#ifndef USTRING_H 
+#define USTRING_H <string.h>
+#endif
+
+#include USTDLIB_H
+#include USTRING_H
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(UTOPIA_NO_THREADS)
+#define UTOPIA_SSET_THREADS
+#include <pthread.h>
+#endif
+
+/* Hashable Implementation */
+
+#ifndef UTOPIA_HASHABLE_IMPLEMENTED
+#define UTOPIA_HASHABLE_IMPLEMENTED
+
+#ifndef UTOPIA_HASH_SIZE
+#define UTOPIA_HASH_SIZE 32
+#endif
+
+static void* memdup(const void* src, size_t size)
+{
+    void* dup = malloc(size);
+    memcpy(dup, src, size);
+    return dup;
+}
+
+static size_t hash_default(const void* key)
+{
+#ifndef UTOPIA_HASH_UINT
+    int c;
+    size_t hash = 5381;
+    const unsigned char* str = *(unsigned char**)key;
+    while ((c = *str++)) {
+        hash = ((hash << 5) + hash) + c;
+    }
+    return hash;
+#else
+    size_t x = *(size_t*)key;
+    x = ((x >> 16) ^ x) * 0x45d9f3b;
+    x = ((x >> 16) ^ x) * 0x45d9f3b;
+    return (x >> 16) ^ x;
+#endif
+}
+
+#endif /* UTOPIA_HASHABLE_IMPLEMENTED */
+
+/***********************************
+Sharded Hash Set for Parallel Dedup
+***********************************/
+
+#ifndef UTOPIA_SSET_SHARDS
+#define UTOPIA_SSET_SHARDS 64
+#endif
+
+#ifndef UTOPIA_SSET_SLOTS
+#define UTOPIA_SSET_SLOTS 16
+#endif
+
+#define SSET_SHARD(sset, hash) ((sset)->shards + sset_mix(hash) % (sset)->count)
+
+static size_t sset_mix(size_t x)
+{
+    x = ((x >> 16) ^ x) * 0x45d9f3b;
+    x = ((x >> 16) ^ x) * 0x45d9f3b;
+    return (x >> 16) ^ x;
+}
+
+static size_t* sshard_probe(const struct sshard* shard, const size_t hash)
+{
+    size_t i = hash & (shard->mod - 1);
+    while (shard->slots[i] && shard->hashes[shard->slots[i] - 1] != hash) {
+        i = (i + 1) & (shard->mod - 1);
+    }
+    return shard->slots + i;
+}
+
+static void sshard_grow(struct sshard* shard, const size_t bytes)
+{
+    size_t i;
+    shard->mod = shard->mod ? shard->mod * 2 : UTOPIA_SSET_SLOTS;
+    shard->hashes = realloc(shard->hashes, shard->mod / 2 * sizeof(size_t));
+    shard->data = realloc(shard->data, shard->mod / 2 * bytes);
+    free(shard->slots);
+    shard->slots = calloc(shard->mod, sizeof(size_t));
+    for (i = 0; i < shard->size; ++i) {
+        *sshard_probe(shard, shard->hashes[i]) = i + 1;
+    }
+}
+
+static int sshard_push(struct sshard* shard, const void* data, const size_t hash, const size_t bytes)
+{
+    size_t* slot = NULL;
+    if (shard->mod) {
+        slot = sshard_probe(shard, hash);
+        if (*slot) {
+            return 0;
+        }
+    }
+
+    if (shard->size == shard->mod / 2) {
+        sshard_grow(shard, bytes);
+        slot = sshard_probe(shard, hash);
+    }
+
+    *slot = shard->size + 1;
+    shard->hashes[shard->size] = hash;
+    memcpy((char*)shard->data + shard->size * bytes, data, bytes);
+    ++shard->size;
+    return 1;
+}
+
+/* Parallel Batch Implementation */
+
+struct ssetbuild {
+    struct sset* sset;
+    const char* data;
+    size_t* hashes;
+    size_t* counts;
+    size_t* order;
+    char* inserted;
+    size_t pushed;
+    size_t count;
+    size_t threads;
+    size_t thread;
+};
+
+#define SSET_BUILD_CHUNK(n, t) (((n) + (t) - 1) / (t))
+#define SSET_BUILD_BEGIN(b) ((b)->thread * SSET_BUILD_CHUNK((b)->count, (b)->threads))
+#define SSET_BUILD_END(b) (SSET_BUILD_BEGIN(b) + SSET_BUILD_CHUNK((b)->count, (b)->threads) < (b)->count ? \
+                           SSET_BUILD_BEGIN(b) + SSET_BUILD_CHUNK((b)->count, (b)->threads) : (b)->count)
+#define SSET_BUILD_COUNT(b, thread, shard) ((b)->counts[(thread) * (b)->sset->count + (shard)])
+
+static void* sset_build_hash(void* arg)
+{
+    size_t i;
+    struct ssetbuild* b = arg;
+    const size_t end = SSET_BUILD_END(b);
+    for (i = SSET_BUILD_BEGIN(b); i < end; ++i) {
+        b->hashes[i] = b->sset->func(b->data + i * b->sset->bytes);
+        ++SSET_BUILD_COUNT(b, b->thread, SSET_SHARD(b->sset, b->hashes[i]) - b->sset->shards);
+    }
+    return NULL;
+}
+
+static void* sset_build_scatter(void* arg)
+{
+    size_t i;
+    struct ssetbuild* b = arg;
+    const size_t end = SSET_BUILD_END(b);
+    for (i = SSET_BUILD_BEGIN(b); i < end; ++i) {
+        const size_t shard = SSET_SHARD(b->sset, b->hashes[i]) - b->sset->shards;
+        b->order[SSET_BUILD_COUNT(b, b->thread, shard)++] = i;
+    }
+    return NULL;
+}
+
+static void* sset_build_insert(void* arg)
+{
+    size_t s, begin, end;
+    struct ssetbuild* b = arg;
+    const size_t bytes = b->sset->bytes;
+    for (s = b->thread; s < b->sset->count; s += b->threads) {
+        begin = s ? SSET_BUILD_COUNT(b, b->threads - 1, s - 1) : 0;
+        end = SSET_BUILD_COUNT(b, b->threads - 1, s);
+        for (; begin < end; ++begin) {
+            const int pushed = sshard_push(b->sset->shards + s, b->data + b->order[begin] * bytes, 
+                                           b->hashes[b->order[begin]], bytes);
+            if (b->inserted) {
+                b->inserted[b->order[begin]] = (char)pushed;
+            }
+            b->pushed += pushed;
+        }
+    }
+    return NULL;
+}
+
+static void sset_build_run(struct ssetbuild* builds, void* (*worker)(void*))
+{
+    size_t i;
+    const size_t threads = builds->threads;
+#ifdef UTOPIA_SSET_THREADS
+    pthread_t* handles = malloc(threads * sizeof(pthread_t));
+    int* spawned = calloc(threads, sizeof(int));
+    for (i = 1; i < threads; ++i) {
+        spawned[i] = !pthread_create(handles + i, NULL, worker, builds + i);
+        if (!spawned[i]) {
+            worker(builds + i);
+        }
+    }
+
+    worker(builds);
+    for (i = 1; i < threads; ++i) {
+        if (spawned[i]) {
+            pthread_join(handles[i], NULL);
+        }
+    }
+
+    free(spawned);
+    free(handles);
+#else
+    for (i = 0; i < threads; ++i) {
+        worker(builds + i);
+    }
+#endif
+}
+
+/* Sharded Set Implementation */
+
+struct sset sset_create(const size_t bytes, const size_t shards)
+{
+    struct sset sset;
+    sset.count = shards ? shards : UTOPIA_SSET_SHARDS;
+    sset.shards = calloc(sset.count, sizeof(struct sshard));
+    sset.bytes = bytes + !bytes;
+    sset.func = &hash_default;
+    return sset;
+}
+
+struct sset sset_copy(const struct sset* sset)
+{
+    size_t i;
+    struct sset s = *sset;
+    s.shards = memdup(sset->shards, sset->count * sizeof(struct sshard));
+    for (i = 0; i < sset->count; ++i) {
+        const struct sshard* shard = sset->shards + i;
+        if (shard->mod) {
+            s.shards[i].slots = memdup(shard->slots, shard->mod * sizeof(size_t));
+            s.shards[i].hashes = memdup(shard->hashes, shard->mod / 2 * sizeof(size_t));
+            s.shards[i].data = memdup(shard->data, shard->mod / 2 * sset->bytes);
+        }
+    }
+    return s;
+}
+
+void sset_overload(struct sset* sset, size_t (*func)(const void*))
+{
+    sset->func = func;
+}
+
+int sset_search(const struct sset* sset, const void* data)
+{
+    const size_t hash = sset->func(data);
+    const struct sshard* shard = SSET_SHARD(sset, hash);
+    return shard->mod ? !!*sshard_probe(shard, hash) : 0;
+}
+
+int sset_push(struct sset* sset, const void* data)
+{
+    const size_t hash = sset->func(data);
+    return sshard_push(SSET_SHARD(sset, hash), data, hash, sset->bytes);
+}
+
+size_t sset_push_batch(struct sset* sset, const void* data, const size_t count, 
+                       const size_t nthreads, char* inserted)
+{
+    size_t i, j, sum, threads = nthreads + !nthreads;
+    struct ssetbuild* builds;
+    threads = threads < count ? threads : count;
+    if (threads <= 1) {
+        const char* ptr = data;
+        for (sum = 0, i = 0; i < count; ++i, ptr += sset->bytes) {
+            const int pushed = sset_push(sset, ptr);
+            if (inserted) {
+                inserted[i] = (char)pushed;
+            }
+            sum += pushed;
+        }
+        return sum;
+    }
+
+    builds = malloc(threads * sizeof(struct ssetbuild));
+    builds->sset = sset;
+    builds->data = data;
+    builds->hashes = malloc(count * sizeof(size_t));
+    builds->counts = calloc(threads * sset->count, sizeof(size_t));
+    builds->order = malloc(count * sizeof(size_t));
+    builds->inserted = inserted;
+    builds->pushed = 0;
+    builds->count = count;
+    builds->threads = threads;
+    for (i = 0; i < threads; ++i) {
+        builds[i] = builds[0];
+        builds[i].thread = i;
+    }
+
+    sset_build_run(builds, &sset_build_hash);
+    for (sum = 0, j = 0; j < sset->count; ++j) {
+        for (i = 0; i < threads; ++i) {
+            const size_t n = SSET_BUILD_COUNT(builds, i, j);
+            SSET_BUILD_COUNT(builds, i, j) = sum;
+            sum += n;
+        }
+    }
+
+    sset_build_run(builds, &sset_build_scatter);
+    sset_build_run(builds, &sset_build_insert);
+    for (sum = 0, i = 0; i < threads; ++i) {
+        sum += builds[i].pushed;
+    }
+
+    free(builds->hashes);
+    free(builds->counts);
+    free(builds->order);
+    free(builds);
+    return sum;
+}
+
+size_t sset_size(const struct sset* sset)
+{
+    size_t i, size = 0;
+    for (i = 0; i < sset->count; ++i) {
+        size += sset->shards[i].size;
+    }
+    return size;
+}
+
+size_t sset_bytes(const struct sset* sset)
+{
+    size_t i, bytes = sset->count * sizeof(struct sshard);
+    for (i = 0; i < sset->count; ++i) {
+        const size_t mod = sset->shards[i].mod;
+        bytes += mod * sizeof(size_t) + mod / 2 * (sizeof(size_t) + sset->bytes);
+    }
+    return bytes;
+}
+
+size_t sset_to_array(const struct sset* sset, void* buffer)
+{
+    size_t i, size = 0;
+    for (i = 0; i < sset->count; ++i) {
+        const struct sshard* shard = sset->shards + i;
+        if (buffer) {
+            memcpy((char*)buffer + size * sset->bytes, shard->data, shard->size * sset->bytes);
+        }
+        size += shard->size;
+    }
+    return size;
+}
+
+void sset_free(struct sset* sset)
+{
+    size_t i;
+    for (i = 0; i < sset->count; ++i) {
+        free(sset->shards[i].slots);
+        free(sset->shards[i].hashes);
+        free(sset->shards[i].data);
+    }
+    free(sset->shards);
+    sset->shards = NULL;
+    sset->count = 0;
+}
+
+#endif /* UTOPIA_SSET_IMPLEMENTED */
+#endif /* UTOPIA_IMPLEMENTATION */
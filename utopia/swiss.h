@@ -0,0 +1,559 @@
+
+/*  Copyright (c) 2022 Eugenio Arteaga A.
+
+Permission is hereby granted, free of charge, to any 
+person obtaining a copy of this software and associated 
+documentation files (the "Software"), to deal in the 
+Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to 
+permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice 
+shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+#ifndef UTOPIA_SWISS_H
+#define UTOPIA_SWISS_H
+
+/*=======================================================
+**************  UTOPIA UTILITY LIBRARY   ****************
+Simple and easy generic containers & data structures in C 
+================================== @Eugenio Arteaga A. */
+
+/*****************************************
+Open Addressing <Key, Value> Swiss Table
+*****************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef USTDDEF_H
+#define USTDDEF_H <stddef.h>
+#endif
+
+#include USTDDEF_H
+
+/* swiss is a separate engine with the map_* calling conventions, struct map keeps
+its chained buckets because frozen pilots, packed indices, incremental rehash
+and mmap images are all laid out per hash % mod bucket. A slot holds 32 bits of
+the hash next to a 32-bit index, so probes reach the key without a hashes[]
+load */
+
+struct swiss_slot {
+    unsigned int check;
+    unsigned int index;
+};
+
+struct swiss {
+    unsigned char* ctrl;
+    struct swiss_slot* slots;
+    size_t* hashes;
+    void* keys;
+    void* values;
+    size_t key_bytes;
+    size_t value_bytes;
+    size_t size;
+    size_t mod;
+    size_t growth;
+    size_t (*func)(const void*);
+    int (*eq)(const void*, const void*);
+};
+
+#define _swiss_key_at(swiss, i) ((char*)(swiss)->keys + (swiss)->key_bytes * (i))
+#define _swiss_value_at(swiss, i) ((char*)(swiss)->values + (swiss)->value_bytes * (i))
+
+struct swiss swiss_create(const size_t key_size, const size_t value_size);
+struct swiss swiss_reserve(const size_t key_size, const size_t value_size, const size_t reserve);
+struct swiss swiss_copy(const struct swiss* swiss);
+size_t swiss_search(const struct swiss* swiss, const void* key);
+/* overloading the hash replaces the default strcmp equality with a memcmp of
+the key bytes, set swiss_overload_eq (e.g. equal_string) for char* keys */
+void swiss_overload(struct swiss* swiss, size_t (*hash_func)(const void*));
+void swiss_overload_eq(struct swiss* swiss, int (*eq_func)(const void*, const void*));
+void* swiss_key_at(const struct swiss* swiss, const size_t index);
+void* swiss_value_at(const struct swiss* swiss, const size_t index);
+size_t swiss_size(const struct swiss* swiss);
+size_t swiss_capacity(const struct swiss* swiss);
+size_t swiss_key_bytes(const struct swiss* swiss);
+size_t swiss_value_bytes(const struct swiss* swiss);
+/* slot indices are 32 bits wide, a swiss holds at most UTOPIA_SWISS_MAX entries
+(2^32 - 1 by default), swiss_resize clamps to it and swiss_push returns NULL */
+void swiss_resize(struct swiss* swiss, const size_t size);
+void* swiss_push(struct swiss* swiss, const void* key, const void* value);
+size_t swiss_push_if(struct swiss* swiss, const void* key, const void* value);
+int swiss_remove(struct swiss* swiss, const void* key);
+void swiss_free(struct swiss* swiss);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* UTOPIA_SWISS_H */
+
+#ifdef UTOPIA_IMPLEMENTATION
+
+#ifndef UTOPIA_SWISS_IMPLEMENTED
+#define UTOPIA_SWISS_IMPLEMENTED
+
+#ifndef USTDLIB_H 
+#define USTDLIB_H <stdlib.h>
+#endif
+
+#ifndef USTRING_H 
+#define USTRING_H <string.h>
+#endif
+
+#include USTDLIB_H
+#include USTRING_H
+
+#ifndef UTOPIA_SWISS_MAX
+#define UTOPIA_SWISS_MAX 0xFFFFFFFF
+#endif
+
+#if UTOPIA_SWISS_MAX > 0xFFFFFFFF
+#error "UTOPIA_SWISS_MAX must not exceed 0xFFFFFFFF"
+#endif
+
+#if defined(__SSE2__) && !defined(UTOPIA_NO_SIMD)
+#define UTOPIA_SWISS_SSE2
+#include <emmintrin.h>
+#endif
+
+/* Hashable Implementation */
+
+#ifndef UTOPIA_HASHABLE_IMPLEMENTED
+#define UTOPIA_HASHABLE_IMPLEMENTED
+
+#ifndef UTOPIA_HASH_SIZE
+#define UTOPIA_HASH_SIZE 32
+#endif
+
+static void* memdup(const void* src, size_t size)
+{
+    void* dup = malloc(size);
+    memcpy(dup, src, size);
+    return dup;
+}
+
+static size_t hash_default(const void* key)
+{
+#ifndef UTOPIA_HASH_UINT
+    int c;
+    size_t hash = 5381;
+    const unsigned char* str = *(unsigned char**)key;
+    while ((c = *str++)) {
+        hash = ((hash << 5) + hash) + c;
+    }
+    return hash;
+#else
+    size_t x = *(size_t*)key;
+    x = ((x >> 16) ^ x) * 0x45d9f3b;
+    x = ((x >> 16) ^ x) * 0x45d9f3b;
+    return (x >> 16) ^ x;
+#endif
+}
+
+#endif /* UTOPIA_HASHABLE_IMPLEMENTED */
+
+/* Equality Implementation */
+
+#ifndef UTOPIA_EQUALS_IMPLEMENTED
+#define UTOPIA_EQUALS_IMPLEMENTED
+
+static int equal_default(const void* a, const void* b)
+{
+#ifndef UTOPIA_HASH_UINT
+    return !strcmp(*(char**)a, *(char**)b);
+#else
+    return *(size_t*)a == *(size_t*)b;
+#endif
+}
+
+#endif /* UTOPIA_EQUALS_IMPLEMENTED */
+
+/* Control Group Implementation */
+
+#define SWISS_GROUP 16
+#define SWISS_EMPTY 0x80
+#define SWISS_DELETED 0xFE
+
+#define SWISS_H1(hash) ((hash) >> 7)
+#define SWISS_H2(hash) ((unsigned char)((hash) & 0x7F))
+#define SWISS_CHECK(hash) ((unsigned int)((hash) >> (sizeof(size_t) * 8 - 32)))
+#define SWISS_LOAD(mod) ((mod) - (mod) / 8)
+
+static unsigned int swiss_group_match(const unsigned char* group, const unsigned char tag)
+{
+#ifdef UTOPIA_SWISS_SSE2
+    const __m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+    return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)tag)));
+#else
+    unsigned int i, mask = 0;
+    for (i = 0; i < SWISS_GROUP; ++i) {
+        mask |= (unsigned int)(group[i] == tag) << i;
+    }
+    return mask;
+#endif
+}
+
+static unsigned int swiss_group_free(const unsigned char* group)
+{
+#ifdef UTOPIA_SWISS_SSE2
+    const __m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+    return (unsigned int)_mm_movemask_epi8(ctrl);
+#else
+    unsigned int i, mask = 0;
+    for (i = 0; i < SWISS_GROUP; ++i) {
+        mask |= (unsigned int)(group[i] >> 7) << i;
+    }
+    return mask;
+#endif
+}
+
+static unsigned int swiss_trailing_zeros(const unsigned int mask)
+{
+#ifdef __GNUC__
+    return (unsigned int)__builtin_ctz(mask);
+#else
+    unsigned int n = 0;
+    while (!(mask & (1U << n))) {
+        ++n;
+    }
+    return n;
+#endif
+}
+
+static unsigned int swiss_leading_zeros(const unsigned int mask)
+{
+    unsigned int n = 0;
+    while (n < SWISS_GROUP && !(mask & (1U << (SWISS_GROUP - 1 - n)))) {
+        ++n;
+    }
+    return n;
+}
+
+static void swiss_ctrl_set(struct swiss* swiss, const size_t slot, const unsigned char tag)
+{
+    swiss->ctrl[slot] = tag;
+    if (slot < SWISS_GROUP) {
+        swiss->ctrl[swiss->mod + slot] = tag;
+    }
+}
+
+static int swiss_key_equal(const struct swiss* swiss, const void* a, const void* b)
+{
+    return swiss->eq ? swiss->eq(a, b) : !memcmp(a, b, swiss->key_bytes);
+}
+
+static size_t swiss_find_key(const struct swiss* swiss, const void* key, const size_t hash)
+{
+    const size_t mask = swiss->mod - 1;
+    const unsigned char tag = SWISS_H2(hash);
+    size_t pos = SWISS_H1(hash) & mask, step = 0;
+
+    while (1) {
+        const unsigned char* group = swiss->ctrl + pos;
+        unsigned int bits = swiss_group_match(group, tag);
+        while (bits) {
+            const size_t slot = (pos + swiss_trailing_zeros(bits)) & mask;
+            const struct swiss_slot* find = swiss->slots + slot;
+            if (find->check == SWISS_CHECK(hash) && 
+                swiss_key_equal(swiss, _swiss_key_at(swiss, find->index), key)) {
+                return slot + 1;
+            }
+            bits &= bits - 1;
+        }
+
+        if (swiss_group_match(group, SWISS_EMPTY)) {
+            return 0;
+        }
+
+        step += SWISS_GROUP;
+        pos = (pos + step) & mask;
+    }
+}
+
+static size_t swiss_find_index(const struct swiss* swiss, const size_t index)
+{
+    const size_t mask = swiss->mod - 1;
+    const size_t hash = swiss->hashes[index];
+    const unsigned char tag = SWISS_H2(hash);
+    size_t pos = SWISS_H1(hash) & mask, step = 0;
+
+    while (1) {
+        const unsigned char* group = swiss->ctrl + pos;
+        unsigned int bits = swiss_group_match(group, tag);
+        while (bits) {
+            const size_t slot = (pos + swiss_trailing_zeros(bits)) & mask;
+            if (swiss->slots[slot].index == index) {
+                return slot + 1;
+            }
+            bits &= bits - 1;
+        }
+
+        if (swiss_group_match(group, SWISS_EMPTY)) {
+            return 0;
+        }
+
+        step += SWISS_GROUP;
+        pos = (pos + step) & mask;
+    }
+}
+
+static size_t swiss_find_free(const struct swiss* swiss, const size_t hash)
+{
+    const size_t mask = swiss->mod - 1;
+    size_t pos = SWISS_H1(hash) & mask, step = 0;
+
+    while (1) {
+        const unsigned int bits = swiss_group_free(swiss->ctrl + pos);
+        if (bits) {
+            return (pos + swiss_trailing_zeros(bits)) & mask;
+        }
+
+        step += SWISS_GROUP;
+        pos = (pos + step) & mask;
+    }
+}
+
+static void swiss_insert(struct swiss* swiss, const size_t hash, const size_t index)
+{
+    const size_t slot = swiss_find_free(swiss, hash);
+    swiss->growth -= (swiss->ctrl[slot] == SWISS_EMPTY);
+    swiss_ctrl_set(swiss, slot, SWISS_H2(hash));
+    swiss->slots[slot].check = SWISS_CHECK(hash);
+    swiss->slots[slot].index = (unsigned int)index;
+}
+
+static void swiss_erase(struct swiss* swiss, const size_t slot)
+{
+    const size_t mask = swiss->mod - 1;
+    const unsigned int before = swiss_group_match(swiss->ctrl + ((slot - SWISS_GROUP) & mask), SWISS_EMPTY);
+    const unsigned int after = swiss_group_match(swiss->ctrl + slot, SWISS_EMPTY);
+    
+    if (before && after && 
+        swiss_trailing_zeros(after) + swiss_leading_zeros(before) < SWISS_GROUP) {
+        swiss_ctrl_set(swiss, slot, SWISS_EMPTY);
+        ++swiss->growth;
+    } 
+    else swiss_ctrl_set(swiss, slot, SWISS_DELETED);
+}
+
+/*****************************************
+Open Addressing <Key, Value> Swiss Table
+*****************************************/
+
+struct swiss swiss_create(const size_t key_size, const size_t value_size)
+{
+    struct swiss swiss;
+    swiss.ctrl = NULL;
+    swiss.slots = NULL;
+    swiss.hashes = NULL;
+    swiss.keys = NULL;
+    swiss.values = NULL;
+    swiss.key_bytes = key_size + !key_size;
+    swiss.value_bytes = value_size + !value_size;
+    swiss.size = 0;
+    swiss.mod = 0;
+    swiss.growth = 0;
+    swiss.func = &hash_default;
+    swiss.eq = &equal_default;
+    return swiss;
+}
+
+struct swiss swiss_reserve(const size_t key_size, const size_t value_size, const size_t reserve)
+{
+    struct swiss swiss = swiss_create(key_size, value_size);
+    if (reserve) {
+        swiss_resize(&swiss, reserve);
+    }
+    return swiss;
+}
+
+struct swiss swiss_copy(const struct swiss* swiss)
+{
+    struct swiss s = *swiss;
+    if (swiss->mod) {
+        const size_t cap = SWISS_LOAD(swiss->mod);
+        s.ctrl = memdup(swiss->ctrl, swiss->mod + SWISS_GROUP);
+        s.slots = memdup(swiss->slots, swiss->mod * sizeof(struct swiss_slot));
+        s.hashes = memdup(swiss->hashes, cap * sizeof(size_t));
+        s.keys = memdup(swiss->keys, cap * swiss->key_bytes);
+        s.values = memdup(swiss->values, cap * swiss->value_bytes);
+    }
+    return s;
+}
+
+size_t swiss_capacity(const struct swiss* swiss)
+{
+    return SWISS_LOAD(swiss->mod);
+}
+
+void swiss_overload(struct swiss* swiss, size_t (*func)(const void*))
+{
+    swiss->func = func;
+    if (swiss->eq == &equal_default) {
+        swiss->eq = NULL;
+    }
+}
+
+void swiss_overload_eq(struct swiss* swiss, int (*eq)(const void*, const void*))
+{
+    swiss->eq = eq;
+}
+
+void* swiss_key_at(const struct swiss* swiss, const size_t index)
+{
+    return _swiss_key_at(swiss, index);
+}
+
+void* swiss_value_at(const struct swiss* swiss, const size_t index)
+{
+    return _swiss_value_at(swiss, index);
+}
+
+size_t swiss_size(const struct swiss* swiss)
+{
+    return swiss->size;
+}
+
+size_t swiss_key_bytes(const struct swiss* swiss)
+{
+    return swiss->key_bytes;
+}
+
+size_t swiss_value_bytes(const struct swiss* swiss)
+{
+    return swiss->value_bytes;
+}
+
+size_t swiss_search(const struct swiss* swiss, const void* key)
+{
+    if (swiss->size) {
+        const size_t slot = swiss_find_key(swiss, key, swiss->func(key));
+        if (slot) {
+            return swiss->slots[slot - 1].index + 1;
+        }
+    }
+
+    return 0;
+}
+
+void swiss_resize(struct swiss* swiss, const size_t new_size)
+{
+    size_t i, cap, mod = SWISS_GROUP;
+    cap = new_size + !new_size * UTOPIA_HASH_SIZE;
+    cap = cap > swiss->size ? cap : swiss->size;
+    cap = cap < UTOPIA_SWISS_MAX ? cap : UTOPIA_SWISS_MAX;
+    while (SWISS_LOAD(mod) < cap) {
+        mod <<= 1;
+    }
+
+    cap = SWISS_LOAD(mod);
+    swiss->mod = mod;
+    swiss->growth = cap;
+    swiss->hashes = realloc(swiss->hashes, cap * sizeof(size_t));
+    swiss->keys = realloc(swiss->keys, cap * swiss->key_bytes);
+    swiss->values = realloc(swiss->values, cap * swiss->value_bytes);
+    swiss->slots = realloc(swiss->slots, mod * sizeof(struct swiss_slot));
+    swiss->ctrl = realloc(swiss->ctrl, mod + SWISS_GROUP);
+    memset(swiss->ctrl, SWISS_EMPTY, mod + SWISS_GROUP);
+
+    for (i = 0; i < swiss->size; ++i) {
+        swiss_insert(swiss, swiss->hashes[i], i);
+    }
+}
+
+int swiss_remove(struct swiss* swiss, const void* key)
+{
+    if (swiss->size) {
+        const size_t slot = swiss_find_key(swiss, key, swiss->func(key));
+        if (slot) {
+            const size_t find = swiss->slots[slot - 1].index;
+            const size_t last = swiss->size - 1;
+
+            swiss_erase(swiss, slot - 1);
+            if (find != last) {
+                const size_t move = swiss_find_index(swiss, last);
+                swiss->slots[move - 1].index = (unsigned int)find;
+                swiss->hashes[find] = swiss->hashes[last];
+                memcpy(_swiss_key_at(swiss, find), _swiss_key_at(swiss, last), swiss->key_bytes);
+                memcpy(_swiss_value_at(swiss, find), _swiss_value_at(swiss, last), swiss->value_bytes);
+            }
+
+            --swiss->size;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+void* swiss_push(struct swiss* swiss, const void* key, const void* value)
+{
+    void* ptr;
+    size_t hash;
+    if (swiss->size >= UTOPIA_SWISS_MAX) {
+        return NULL;
+    }
+
+    hash = swiss->func(key);
+    if (!swiss->growth) {
+        const size_t cap = SWISS_LOAD(swiss->mod);
+        swiss_resize(swiss, swiss->size * 2 >= cap ? cap * 2 : cap);
+    }
+
+    swiss_insert(swiss, hash, swiss->size);
+    swiss->hashes[swiss->size] = hash;
+
+    ptr = _swiss_value_at(swiss, swiss->size);
+    memcpy(_swiss_key_at(swiss, swiss->size), key, swiss->key_bytes);
+    memcpy(ptr, value, swiss->value_bytes);
+    ++swiss->size;
+    return ptr;
+}
+
+size_t swiss_push_if(struct swiss* swiss, const void* key, const void* value)
+{
+    const size_t index = swiss_search(swiss, key);
+    if (index) {
+        return index;
+    }
+
+    swiss_push(swiss, key, value);
+    return 0;
+}
+
+void swiss_free(struct swiss* swiss)
+{
+    if (swiss->ctrl) {
+        free(swiss->ctrl);
+        free(swiss->slots);
+        free(swiss->hashes);
+        free(swiss->keys);
+        free(swiss->values);
+
+        swiss->ctrl = NULL;
+        swiss->slots = NULL;
+        swiss->hashes = NULL;
+        swiss->keys = NULL;
+        swiss->values = NULL;
+        swiss->size = 0;
+        swiss->mod = 0;
+        swiss->growth = 0;
+    }
+}
+
+#endif /* UTOPIA_SWISS_IMPLEMENTED */
+#endif /* UTOPIA_IMPLEMENTATION */
@@ -47,14 +47,19 @@ extern "C" {
 
 struct table {
     size_t* indices;
+    size_t* slots;
     void* data;
     size_t bytes;
     size_t capacity;
     size_t size;
+    size_t mod;
+    size_t count;
+    size_t words;
+    size_t bits;
 };
 
-#define _table_at(table, i) (((char*)(table)->data) + (table)->bytes * i)
-#define _table_index_at(table, i) ((table)->indices[i + 2])
+#define _table_at(table, i) (((char*)(table)->data) + (table)->bytes * (i))
+#define _table_index_at(table, i) (table_index_at((table), (i)))
 #define _table_value_at(table, i) (_table_at((table), _table_index_at(table, i)))
 
 struct table table_create(const size_t bytes);
@@ -66,9 +71,10 @@ struct table table_compress(const void* data, const size_t bytes, const size_t c
 void* table_decompress(const struct table* table, size_t* size);
 void* table_values(const struct table* table);
 void* table_value_at(const struct table* table, const size_t index);
-size_t* table_indices(const struct table* table);
+size_t table_indices(const struct table* table, size_t* buffer);
 size_t table_index_at(const struct table* table, const size_t index);
 size_t table_indices_size(const struct table* table);
+size_t table_index_bits(const struct table* table);
 size_t table_values_size(const struct table* table);
 size_t table_bytes(const struct table* table);
 void table_free(struct table* table);
@@ -94,45 +100,185 @@ void table_free(struct table* table);
 #include USTDLIB_H
 #include USTRING_H
 
-/* Bucket Implementation */
+#if defined(__SSE2__) && !defined(UTOPIA_NO_SIMD)
+#define UTOPIA_TABLE_SSE2
+#include <emmintrin.h>
+#endif
 
-#ifndef UTOPIA_BUCKET_IMPLEMENTED
-#define UTOPIA_BUCKET_IMPLEMENTED
+/* Bit Packing Implementation */
 
-#define BUCKET_CAP_INDEX 0
-#define BUCKET_SIZE_INDEX 1
-#define BUCKET_DATA_INDEX 2
+#define TABLE_WORD_BITS (sizeof(size_t) * 8)
+#define TABLE_WORDS(count, bits) (((count) * (bits) + TABLE_WORD_BITS - 1) / TABLE_WORD_BITS)
+#define TABLE_MASK(bits) ((bits) < TABLE_WORD_BITS ? ((size_t)1 << (bits)) - 1 : ~(size_t)0)
 
-#define BUCKET_SIZE(bucket) (bucket ? bucket[BUCKET_SIZE_INDEX] : 0)
-#define BUCKET_CAP(bucket) (bucket ? bucket[BUCKET_CAP_INDEX] : 0)
-#define BUCKET_DATA(bucket) (bucket ? bucket[BUCKET_DATA_INDEX] : 0)
+static size_t table_unpack(const size_t* words, const size_t bits, const size_t bit)
+{
+    const size_t w = bit / TABLE_WORD_BITS, off = bit % TABLE_WORD_BITS;
+    size_t value = words[w] >> off;
+    if (off + bits > TABLE_WORD_BITS) {
+        value |= words[w + 1] << (TABLE_WORD_BITS - off);
+    }
+    return value & TABLE_MASK(bits);
+}
 
-static size_t* bucket_push(size_t* bucket, size_t index)
+static void table_pack(size_t* words, const size_t bits, const size_t bit, const size_t value)
 {
-    size_t size = BUCKET_SIZE(bucket);
-    size_t cap = BUCKET_CAP(bucket);
+    const size_t w = bit / TABLE_WORD_BITS, off = bit % TABLE_WORD_BITS;
+    const size_t mask = TABLE_MASK(bits);
+    words[w] = (words[w] & ~(mask << off)) | (value << off);
+    if (off + bits > TABLE_WORD_BITS) {
+        const size_t shift = TABLE_WORD_BITS - off;
+        words[w + 1] = (words[w + 1] & ~(mask >> shift)) | (value >> shift);
+    }
+}
+
+#define TABLE_BLOCK 64
+
+#ifdef UTOPIA_TABLE_SSE2
 
-    if (size >= cap) {
-        cap = (!cap + cap) * 2;
-        bucket = realloc(bucket, (cap + BUCKET_DATA_INDEX) * sizeof(size_t));
-        bucket[BUCKET_CAP_INDEX] = cap;
+static void table_widen32(const __m128i v, size_t* out)
+{
+    const __m128i zero = _mm_setzero_si128();
+    _mm_storeu_si128((__m128i*)out, _mm_unpacklo_epi32(v, zero));
+    _mm_storeu_si128((__m128i*)(out + 2), _mm_unpackhi_epi32(v, zero));
+}
+
+static void table_widen16(const __m128i v, size_t* out)
+{
+    const __m128i zero = _mm_setzero_si128();
+    table_widen32(_mm_unpacklo_epi16(v, zero), out);
+    table_widen32(_mm_unpackhi_epi16(v, zero), out + 4);
+}
+
+static void table_widen8(const __m128i v, size_t* out)
+{
+    const __m128i zero = _mm_setzero_si128();
+    table_widen16(_mm_unpacklo_epi8(v, zero), out);
+    table_widen16(_mm_unpackhi_epi8(v, zero), out + 8);
+}
+
+static __m128i table_split(const __m128i v, const int bits)
+{
+    const __m128i mask = _mm_set1_epi8((char)((1 << bits) - 1));
+    const __m128i lo = _mm_and_si128(v, mask);
+    const __m128i hi = _mm_and_si128(_mm_srli_epi16(v, bits), mask);
+    return _mm_unpacklo_epi8(lo, hi);
+}
+
+static size_t table_unpack_sse2(const size_t* words, const size_t bits, const size_t first, const size_t count, size_t* out)
+{
+    size_t i;
+    const unsigned char* src;
+    if (sizeof(size_t) != 8 || (first * bits) % 8 || 
+        (bits != 1 && bits != 2 && bits != 4 && bits != 8 && bits != 16 && bits != 32)) {
+        return 0;
     }
 
-    bucket[BUCKET_DATA_INDEX + size] = index;
-    bucket[BUCKET_SIZE_INDEX] = size + 1;
+    src = (const unsigned char*)words + first * bits / 8;
+    for (i = 0; i + 16 <= count; i += 16, src += 2 * bits) {
+        __m128i v;
+        if (bits >= 8) {
+            v = _mm_loadu_si128((const __m128i*)src);
+            if (bits == 8) {
+                table_widen8(v, out + i);
+            } else if (bits == 16) {
+                table_widen16(v, out + i);
+                table_widen16(_mm_loadu_si128((const __m128i*)(src + 16)), out + i + 8);
+            } else {
+                int j;
+                for (j = 0; j < 4; ++j) {
+                    table_widen32(_mm_loadu_si128((const __m128i*)(src + j * 16)), out + i + j * 4);
+                }
+            }
+            continue;
+        }
 
-    return bucket;
+        if (bits == 4) {
+            v = _mm_loadl_epi64((const __m128i*)src);
+        } else {
+            int w = 0;
+            memcpy(&w, src, 2 * bits);
+            v = _mm_cvtsi32_si128(w);
+        }
+
+        v = table_split(v, 4);
+        if (bits <= 2) {
+            v = table_split(v, 2);
+        }
+        if (bits == 1) {
+            v = table_split(v, 1);
+        }
+        table_widen8(v, out + i);
+    }
+    return i;
 }
 
-static void bucket_remove(size_t* bucket, const size_t index)
+#endif /* UTOPIA_TABLE_SSE2 */
+
+static void table_unpack_range(const struct table* table, const size_t first, const size_t count, size_t* out)
 {
-    const size_t size = BUCKET_SIZE(bucket) + BUCKET_DATA_INDEX;
-    size_t* ptr = bucket + index;
-    memmove(ptr, ptr + 1, (size - index - 1) * sizeof(size_t));
-    bucket[BUCKET_SIZE_INDEX] = size - 1 - BUCKET_DATA_INDEX;
+    size_t i = 0, bit;
+#ifdef UTOPIA_TABLE_SSE2
+    i = table_unpack_sse2(table->indices, table->bits, first, count, out);
+#endif
+    for (bit = (first + i) * table->bits; i < count; ++i, bit += table->bits) {
+        out[i] = table_unpack(table->indices, table->bits, bit);
+    }
 }
 
-#endif /* UTOPIA_BUCKET_IMPLEMENTED */
+static void table_repack(struct table* table, const size_t bits)
+{
+    size_t i;
+    const size_t words = TABLE_WORDS(table->count, bits) + 1;
+    size_t* packed = calloc(words, sizeof(size_t));
+    for (i = 0; i < table->count; ++i) {
+        table_pack(packed, bits, i * bits, table_unpack(table->indices, table->bits, i * table->bits));
+    }
+
+    free(table->indices);
+    table->indices = packed;
+    table->words = words;
+    table->bits = bits;
+}
+
+/* Dictionary Index Implementation */
+
+#ifndef UTOPIA_TABLE_SLOTS
+#define UTOPIA_TABLE_SLOTS 16
+#endif
+
+static size_t table_hash(const void* data, const size_t bytes)
+{
+    size_t i, hash = 2166136261UL;
+    const unsigned char* ptr = data;
+    for (i = 0; i < bytes; ++i) {
+        hash = (hash ^ ptr[i]) * 16777619UL;
+    }
+    return hash ^ (hash >> 15);
+}
+
+static size_t* table_probe(const struct table* table, const void* data)
+{
+    size_t i = table_hash(data, table->bytes) & (table->mod - 1);
+    while (table->slots[i] && memcmp(_table_at(table, table->slots[i] - 1), data, table->bytes)) {
+        i = (i + 1) & (table->mod - 1);
+    }
+    return table->slots + i;
+}
+
+static void table_rehash(struct table* table, const size_t mod)
+{
+    size_t i, *slot;
+    free(table->slots);
+    table->mod = mod;
+    table->slots = calloc(mod, sizeof(size_t));
+    for (i = 0; i < table->size; ++i) {
+        slot = table_probe(table, _table_at(table, i));
+        if (!*slot) {
+            *slot = i + 1;
+        }
+    }
+}
 
 /**********************
 Unordered Indexed Table
@@ -142,29 +288,43 @@ struct table table_create(const size_t bytes)
 {
     struct table table;
     table.indices = NULL;
+    table.slots = NULL;
     table.data = NULL;
     table.bytes = bytes + !bytes;
     table.size = 0;
     table.capacity = 0;
+    table.mod = 0;
+    table.count = 0;
+    table.words = 0;
+    table.bits = 0;
     return table;
 }
 
 size_t table_search(const struct table* table, const void* data)
 {
-    size_t i;
-    const size_t bytes = table->bytes, count = table->size;
-    const char* ptr = table->data;
-    for (i = 0; i < count; ++i, ptr += bytes) {
-        if (!memcmp(ptr, data, bytes)) {
-            return i + 1;
-        }
-    }
-    return 0;
+    return table->mod ? *table_probe(table, data) : 0;
 }
 
 void table_push_index(struct table* table, const size_t index)
 {
-    table->indices = bucket_push(table->indices, index);
+    size_t bits = table->bits + !table->bits;
+    while (bits < TABLE_WORD_BITS && index >> bits) {
+        ++bits;
+    }
+
+    if (bits != table->bits) {
+        table_repack(table, bits);
+    }
+
+    if (TABLE_WORDS(table->count + 1, table->bits) > table->words) {
+        const size_t words = table->words * 2;
+        table->indices = realloc(table->indices, words * sizeof(size_t));
+        memset(table->indices + table->words, 0, (words - table->words) * sizeof(size_t));
+        table->words = words;
+    }
+
+    table_pack(table->indices, table->bits, table->count * table->bits, index);
+    ++table->count;
 }
 
 void table_push_data(struct table* table, const void* data)
@@ -174,6 +334,16 @@ void table_push_data(struct table* table, const void* data)
         table->data = realloc(table->data, table->capacity * table->bytes);
     }
     memcpy(_table_at(table, table->size++), data, table->bytes);
+
+    if (table->size * 2 > table->mod) {
+        table_rehash(table, table->mod ? table->mod * 2 : UTOPIA_TABLE_SLOTS);
+    }
+    else {
+        size_t* slot = table_probe(table, data);
+        if (!*slot) {
+            *slot = table->size;
+        }
+    }
 }
 
 size_t table_push(struct table* table, const void* data)
@@ -191,21 +361,18 @@ size_t table_push(struct table* table, const void* data)
 void table_remove(struct table* table, const size_t index)
 {
     if (table->indices) {
-        size_t size;
-        size_t* indices, i;
+        size_t i, j, find;
         char* ptr = _table_at(table, index);
         memmove(ptr, ptr + table->bytes, (--table->size - index) * table->bytes);
+        table_rehash(table, table->mod);
         
-        indices = table_indices(table);
-        size = table_indices_size(table);
-        for (i = 0; i < size; ++i) {
-            if (indices[i] == index) {
-                bucket_remove(table->indices, (size_t)i);
-            } 
-            else if (table->indices[i] > index) {
-                --table->indices[i];
+        for (i = 0, j = 0; i < table->count; ++i) {
+            find = table_unpack(table->indices, table->bits, i * table->bits);
+            if (find != index) {
+                table_pack(table->indices, table->bits, j++ * table->bits, find - (find > index));
             }
         }
+        table->count = j;
     }
 }
 
@@ -225,19 +392,21 @@ struct table table_compress(const void* data, const size_t bytes, const size_t c
 
 void* table_decompress(const struct table* table, size_t* size)
 {
-    size_t i;
+    size_t i, j, n, block[TABLE_BLOCK];
     void* data;
     char* ptr;
 
-    const size_t count = BUCKET_SIZE(table->indices) + BUCKET_DATA_INDEX;
-    *size = BUCKET_SIZE(table->indices);
-
+    *size = table->count;
     data = malloc(*size * table->bytes);
     ptr = data;
     
-    for (i = BUCKET_DATA_INDEX; i < count; ++i) {
-        memcpy(ptr, _table_at(table, table->indices[i]), table->bytes);
-        ptr += table->bytes;
+    for (i = 0; i < table->count; i += n) {
+        n = table->count - i < TABLE_BLOCK ? table->count - i : TABLE_BLOCK;
+        table_unpack_range(table, i, n, block);
+        for (j = 0; j < n; ++j) {
+            memcpy(ptr, _table_at(table, block[j]), table->bytes);
+            ptr += table->bytes;
+        }
     }
 
     return data;
@@ -253,19 +422,27 @@ void* table_value_at(const struct table* table, const size_t index)
     return _table_value_at(table, index);
 }
 
-size_t* table_indices(const struct table* table)
+size_t table_indices(const struct table* table, size_t* buffer)
 {
-    return table->indices + BUCKET_DATA_INDEX;
+    if (buffer) {
+        table_unpack_range(table, 0, table->count, buffer);
+    }
+    return table->count;
 }
 
 size_t table_index_at(const struct table* table, const size_t index)
 {
-    return _table_index_at(table, index);
+    return table_unpack(table->indices, table->bits, index * table->bits);
 }
 
 size_t table_indices_size(const struct table* table)
 {
-    return BUCKET_SIZE(table->indices);
+    return table->count;
+}
+
+size_t table_index_bits(const struct table* table)
+{
+    return table->bits;
 }
 
 size_t table_values_size(const struct table* table)
@@ -280,14 +457,20 @@ size_t table_bytes(const struct table* table)
 
 void table_free(struct table* table)
 {
-    if (table->data) {
+    if (table->data || table->indices) {
         free(table->data);
         free(table->indices);
+        free(table->slots);
 
         table->data = NULL;
         table->indices = NULL;
+        table->slots = NULL;
         table->size = 0;
         table->capacity = 0;
+        table->mod = 0;
+        table->count = 0;
+        table->words = 0;
+        table->bits = 0;
     }
 }
 
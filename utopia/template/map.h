@@ -0,0 +1,301 @@
+/*  Copyright (c) 2022 Eugenio Arteaga A.
+
+Permission is hereby granted, free of charge, to any 
+person obtaining a copy of this software and associated 
+documentation files (the "Software"), to deal in the 
+Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to 
+permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice 
+shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+#ifndef UTOPIA_MAP_TEMPLATE_H
+#define UTOPIA_MAP_TEMPLATE_H
+
+/*=======================================================
+**************  UTOPIA UTILITY LIBRARY   ****************
+Simple and easy generic containers & data structures in C 
+================================== @Eugenio Arteaga A. */
+
+/****************************
+Generic <Key, Value> Hash Map
+*****************************/
+
+#ifndef USTDDEF_H
+#define USTDDEF_H <stddef.h>
+#endif
+
+#ifndef USTDLIB_H 
+#define USTDLIB_H <stdlib.h>
+#endif
+
+#ifndef USTRING_H 
+#define USTRING_H <string.h>
+#endif
+
+#include USTDDEF_H
+#include USTDLIB_H
+#include USTRING_H
+
+#ifndef UTOPIA_HASH_SIZE
+#define UTOPIA_HASH_SIZE 32
+#endif
+
+#define map_decl(K, V)                  \
+struct K ## _ ## V ## _map {            \
+    size_t* heads;                      \
+    size_t* next;                       \
+    size_t* hashes;                     \
+    K* keys;                            \
+    V* values;                          \
+    size_t size;                        \
+    size_t mod;                         \
+}
+
+#define map_create_decl(K, V) \
+struct K ## _ ## V ## _map K ## _ ## V ## _map_create(void)
+#define map_reserve_decl(K, V) \
+struct K ## _ ## V ## _map K ## _ ## V ## _map_reserve(const size_t)
+#define map_copy_decl(K, V) \
+struct K ## _ ## V ## _map K ## _ ## V ## _map_copy(const struct K ## _ ## V ## _map*)
+#define map_search_decl(K, V) \
+size_t K ## _ ## V ## _map_search(const struct K ## _ ## V ## _map*, const K*)
+#define map_push_decl(K, V) \
+V* K ## _ ## V ## _map_push(struct K ## _ ## V ## _map*, const K*, const V*)
+#define map_push_if_decl(K, V) \
+size_t K ## _ ## V ## _map_push_if(struct K ## _ ## V ## _map*, const K*, const V*)
+#define map_remove_decl(K, V) \
+int K ## _ ## V ## _map_remove(struct K ## _ ## V ## _map*, const K*)
+#define map_remove_swap_decl(K, V) \
+int K ## _ ## V ## _map_remove_swap(struct K ## _ ## V ## _map*, const K*)
+#define map_resize_decl(K, V) \
+void K ## _ ## V ## _map_resize(struct K ## _ ## V ## _map*, const size_t)
+#define map_free_decl(K, V) \
+void K ## _ ## V ## _map_free(struct K ## _ ## V ## _map*)
+
+#define map_template_decl(K, V) \
+map_decl(K, V);                 \
+map_create_decl(K, V);          \
+map_reserve_decl(K, V);         \
+map_copy_decl(K, V);            \
+map_search_decl(K, V);          \
+map_push_decl(K, V);            \
+map_push_if_decl(K, V);         \
+map_remove_decl(K, V);          \
+map_remove_swap_decl(K, V);     \
+map_resize_decl(K, V);          \
+map_free_decl(K, V)
+
+#define map_template_impl(K, V, hash, eq) \
+map_create_impl(K, V)           \
+map_reserve_impl(K, V)          \
+map_copy_impl(K, V)             \
+map_search_impl(K, V, hash, eq) \
+map_push_impl(K, V, hash)       \
+map_push_if_impl(K, V, hash, eq)\
+map_remove_impl(K, V, hash, eq) \
+map_remove_swap_impl(K, V, hash, eq)\
+map_resize_impl(K, V)           \
+map_free_impl(K, V)             \
+typedef struct K ## _ ## V ## _map utopia_ ## K ## _ ## V ## _map
+
+/****************************
+Generic <Key, Value> Hash Map
+*****************************/
+
+#define map_create_impl(K, V)                       \
+struct K ## _ ## V ## _map K ## _ ## V ## _map_create(void)\
+{                                                   \
+    struct K ## _ ## V ## _map map = {0};           \
+    return map;                                     \
+}
+
+#define map_reserve_impl(K, V)                      \
+struct K ## _ ## V ## _map K ## _ ## V ## _map_reserve(const size_t reserve)\
+{                                                   \
+    struct K ## _ ## V ## _map map = {0};           \
+    if (reserve) {                                  \
+        K ## _ ## V ## _map_resize(&map, reserve);  \
+    }                                               \
+    return map;                                     \
+}
+
+#define map_copy_impl(K, V)                         \
+struct K ## _ ## V ## _map K ## _ ## V ## _map_copy(const struct K ## _ ## V ## _map* map)\
+{                                                   \
+    struct K ## _ ## V ## _map ret = *map;          \
+    if (map->mod) {                                 \
+        ret.heads = (size_t*)malloc(map->mod * sizeof(size_t));\
+        ret.next = (size_t*)malloc(map->mod * sizeof(size_t));\
+        ret.hashes = (size_t*)malloc(map->mod * sizeof(size_t));\
+        ret.keys = (K*)malloc(map->mod * sizeof(K));\
+        ret.values = (V*)malloc(map->mod * sizeof(V));\
+        memcpy(ret.heads, map->heads, map->mod * sizeof(size_t));\
+        memcpy(ret.next, map->next, map->size * sizeof(size_t));\
+        memcpy(ret.hashes, map->hashes, map->size * sizeof(size_t));\
+        memcpy(ret.keys, map->keys, map->size * sizeof(K));\
+        memcpy(ret.values, map->values, map->size * sizeof(V));\
+    }                                               \
+    return ret;                                     \
+}
+
+#define map_search_impl(K, V, hash, eq)             \
+size_t K ## _ ## V ## _map_search(const struct K ## _ ## V ## _map* map, const K* key)\
+{                                                   \
+    if (map->mod) {                                 \
+        const size_t h = hash(key);                 \
+        size_t i = map->heads[h % map->mod];        \
+        while (i) {                                 \
+            if (map->hashes[i - 1] == h && eq(map->keys + i - 1, key)) {\
+                return i;                           \
+            }                                       \
+            i = map->next[i - 1];                   \
+        }                                           \
+    }                                               \
+    return 0;                                       \
+}
+
+#define map_push_impl(K, V, hash)                   \
+V* K ## _ ## V ## _map_push(struct K ## _ ## V ## _map* map, const K* key, const V* value)\
+{                                                   \
+    size_t* head;                                   \
+    const size_t h = hash(key);                     \
+    if (map->size == map->mod) {                    \
+        K ## _ ## V ## _map_resize(map, map->mod * 2);\
+    }                                               \
+                                                    \
+    head = map->heads + h % map->mod;               \
+    map->next[map->size] = *head;                   \
+    *head = map->size + 1;                          \
+    map->hashes[map->size] = h;                     \
+    map->keys[map->size] = *key;                    \
+    map->values[map->size] = *value;                \
+    return map->values + map->size++;               \
+}
+
+#define map_push_if_impl(K, V, hash, eq)            \
+size_t K ## _ ## V ## _map_push_if(struct K ## _ ## V ## _map* map, const K* key, const V* value)\
+{                                                   \
+    const size_t index = K ## _ ## V ## _map_search(map, key);\
+    if (index) {                                    \
+        return index;                               \
+    }                                               \
+                                                    \
+    K ## _ ## V ## _map_push(map, key, value);      \
+    return 0;                                       \
+}
+
+#define map_remove_impl(K, V, hash, eq)             \
+int K ## _ ## V ## _map_remove(struct K ## _ ## V ## _map* map, const K* key)\
+{                                                   \
+    if (map->mod) {                                 \
+        size_t i, find, count;                      \
+        const size_t h = hash(key);                 \
+        size_t* link = map->heads + h % map->mod;   \
+        while (*link) {                             \
+            find = *link - 1;                       \
+            if (map->hashes[find] == h && eq(map->keys + find, key)) {\
+                *link = map->next[find];            \
+                count = --map->size - find;         \
+                memmove(map->next + find, map->next + find + 1, count * sizeof(size_t));\
+                memmove(map->hashes + find, map->hashes + find + 1, count * sizeof(size_t));\
+                memmove(map->keys + find, map->keys + find + 1, count * sizeof(K));\
+                memmove(map->values + find, map->values + find + 1, count * sizeof(V));\
+                for (i = 0; i < map->mod; ++i) {    \
+                    map->heads[i] -= (map->heads[i] > find + 1);\
+                }                                   \
+                for (i = 0; i < map->size; ++i) {   \
+                    map->next[i] -= (map->next[i] > find + 1);\
+                }                                   \
+                return 1;                           \
+            }                                       \
+            link = map->next + find;                \
+        }                                           \
+    }                                               \
+    return 0;                                       \
+}
+
+#define map_remove_swap_impl(K, V, hash, eq)        \
+int K ## _ ## V ## _map_remove_swap(struct K ## _ ## V ## _map* map, const K* key)\
+{                                                   \
+    if (map->mod) {                                 \
+        size_t find, last;                          \
+        const size_t h = hash(key);                 \
+        size_t* link = map->heads + h % map->mod;   \
+        while (*link) {                             \
+            find = *link - 1;                       \
+            if (map->hashes[find] == h && eq(map->keys + find, key)) {\
+                *link = map->next[find];            \
+                last = --map->size;                 \
+                if (find != last) {                 \
+                    link = map->heads + map->hashes[last] % map->mod;\
+                    while (*link != last + 1) {     \
+                        link = map->next + *link - 1;\
+                    }                               \
+                    *link = find + 1;               \
+                    map->next[find] = map->next[last];\
+                    map->hashes[find] = map->hashes[last];\
+                    map->keys[find] = map->keys[last];\
+                    map->values[find] = map->values[last];\
+                }                                   \
+                return 1;                           \
+            }                                       \
+            link = map->next + find;                \
+        }                                           \
+    }                                               \
+    return 0;                                       \
+}
+
+#define map_resize_impl(K, V)                       \
+void K ## _ ## V ## _map_resize(struct K ## _ ## V ## _map* map, const size_t new_size)\
+{                                                   \
+    size_t i, hashmod;                              \
+    map->mod = new_size + !new_size * UTOPIA_HASH_SIZE;\
+    map->mod = map->mod > map->size ? map->mod : map->size;\
+    map->next = (size_t*)realloc(map->next, map->mod * sizeof(size_t));\
+    map->hashes = (size_t*)realloc(map->hashes, map->mod * sizeof(size_t));\
+    map->keys = (K*)realloc(map->keys, map->mod * sizeof(K));\
+    map->values = (V*)realloc(map->values, map->mod * sizeof(V));\
+    map->heads = (size_t*)realloc(map->heads, map->mod * sizeof(size_t));\
+    memset(map->heads, 0, map->mod * sizeof(size_t));\
+                                                    \
+    for (i = 0; i < map->size; ++i) {               \
+        hashmod = map->hashes[i] % map->mod;        \
+        map->next[i] = map->heads[hashmod];         \
+        map->heads[hashmod] = i + 1;                \
+    }                                               \
+}
+
+#define map_free_impl(K, V)                         \
+void K ## _ ## V ## _map_free(struct K ## _ ## V ## _map* map)\
+{                                                   \
+    if (map->heads) {                               \
+        free(map->heads);                           \
+        free(map->next);                            \
+        free(map->hashes);                          \
+        free(map->keys);                            \
+        free(map->values);                          \
+        map->heads = NULL;                          \
+        map->next = NULL;                           \
+        map->hashes = NULL;                         \
+        map->keys = NULL;                           \
+        map->values = NULL;                         \
+        map->size = 0;                              \
+        map->mod = 0;                               \
+    }                                               \
+}
+
+#endif /* UTOPIA_MAP_TEMPLATE_H */